@@ -2,7 +2,35 @@ set(headers ${headers}
 	src/PCH.h 
     src/log.h
     src/util.h
+    src/text.h
+    src/fixed_strings.h
     src/hook.h 
     src/settings.h
+    src/modifier.h
+    src/class_id.h
+    src/combat_class_table.h
+    src/rule_matcher.h
+    src/class_rules.h
+    src/weapon_profiles.h
+    src/form_cache.h
+    src/modifier_ledger.h
+    src/thread_pool.h
+    src/timing_wheel.h
+    src/startup_profile.h
+    src/fixed_containers.h
+    src/push_queue.h
+    src/idle_queue.h
+    src/los_cache.h
+    src/hostility_cache.h
+    src/threat_map.h
+    src/telemetry.h
+    src/assignment.h
+    src/target_allocator.h
     src/combat_classes.h
+    src/serialization.h
+    src/actor_roster.h
+    src/hit_route.h
+    src/event_log.h
+    src/event_replay.h
+    src/papyrus.h
 )
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <optional>
+#include <unordered_set>
+#include <vector>
+#include "fixed_containers.h"
+
+// The follower bookkeeping behind the combat update: who is registered, whose 3D is loaded, who is
+// fighting, and whether the update should keep running. PeriodicUpdateTask keeps it with actor handles;
+// event replay drives the same code without any, so a replayed log goes through the game's own rules.
+template <class Handle>
+class ActorRoster {
+public:
+    struct Tracked {
+        RE::FormID formID;
+        Handle handle;
+    };
+
+private:
+    std::unordered_set<RE::FormID> registered;
+
+    // Probe over registered so unrelated events are rejected without a hash lookup
+    FormIDFilter<4096> registeredFilter;
+
+    // Registered actors whose 3D is loaded
+    std::vector<Tracked> loaded;
+
+    // Registered actors that are currently fighting. Only these get ticked.
+    std::vector<Tracked> fighting;
+
+    // Whether the self-re-enqueuing update is currently scheduled
+    bool ticking = false;
+
+public:
+    // True when the actor wasn't registered yet
+    bool Register(RE::FormID formID) {
+        if (!registered.insert(formID).second) {
+            return false;
+        }
+        registeredFilter.Insert(formID);
+        return true;
+    }
+
+    // True when the actor was registered. The caller unloads it, since only it knows what the handle holds.
+    bool Unregister(RE::FormID formID) {
+        if (registered.erase(formID) == 0) {
+            return false;
+        }
+
+        // Bits can be shared, so rebuild rather than clear this one
+        registeredFilter.Clear();
+        for (auto remaining : registered) {
+            registeredFilter.Insert(remaining);
+        }
+        return true;
+    }
+
+    bool IsRegistered(RE::FormID formID) const {
+        return registeredFilter.MayContain(formID) && registered.contains(formID);
+    }
+
+    // True when a registered actor wasn't loaded yet
+    bool Load(RE::FormID formID, Handle handle) {
+        if (!IsRegistered(formID) || FindLoaded(formID)) {
+            return false;
+        }
+        loaded.push_back({ formID, std::move(handle) });
+        return true;
+    }
+
+    // Takes the actor out of the loaded and fighting lists. Returns its handle if it was loaded.
+    std::optional<Handle> Unload(RE::FormID formID) {
+        std::optional<Handle> handle;
+        if (auto it = std::ranges::find(loaded, formID, &Tracked::formID); it != loaded.end()) {
+            handle = std::move(it->handle);
+            loaded.erase(it);
+        }
+        std::erase_if(fighting, [formID](const Tracked& tracked) { return tracked.formID == formID; });
+        return handle;
+    }
+
+    const Handle* FindLoaded(RE::FormID formID) const {
+        auto it = std::ranges::find(loaded, formID, &Tracked::formID);
+        return it != loaded.end() ? &it->handle : nullptr;
+    }
+
+    // True when a registered actor wasn't fighting yet
+    bool EnterCombat(RE::FormID formID, Handle handle) {
+        if (!IsRegistered(formID) || std::ranges::find(fighting, formID, &Tracked::formID) != fighting.end()) {
+            return false;
+        }
+        fighting.push_back({ formID, std::move(handle) });
+        return true;
+    }
+
+    // True when the actor was fighting
+    bool LeaveCombat(RE::FormID formID) {
+        return std::erase_if(fighting, [formID](const Tracked& tracked) { return tracked.formID == formID; }) > 0;
+    }
+
+    const std::unordered_set<RE::FormID>& GetRegistered() const { return registered; }
+    const std::vector<Tracked>& GetLoaded() const { return loaded; }
+    const std::vector<Tracked>& GetFighting() const { return fighting; }
+
+    // Forgets who is loaded and fighting. Registrations stay.
+    void Reset() {
+        loaded.clear();
+        fighting.clear();
+    }
+
+    // The update is scheduled when someone starts fighting and reschedules itself every frame until nobody
+    // is. Returns true when the caller has to schedule it now.
+    bool StartTicking() {
+        if (ticking || fighting.empty()) {
+            return false;
+        }
+        ticking = true;
+        return true;
+    }
+
+    // Asked by the update before each tick. False once nobody fights, which ends the update until the next fight.
+    bool ContinueTicking() {
+        if (fighting.empty()) {
+            ticking = false;
+            return false;
+        }
+        return true;
+    }
+
+    // The update could not be scheduled
+    void StopTicking() { ticking = false; }
+
+    bool IsTicking() const { return ticking; }
+};
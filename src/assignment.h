@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <span>
+
+// Follower to enemy assignment over a precomputed cost matrix. Kept free of game types so the
+// allocator's choices can be checked on their own.
+namespace CombatClasses {
+    inline constexpr std::uint8_t kUnassigned = 0xFF;
+
+    // Cost of a pair that must never be assigned, e.g. an enemy that isn't hostile to that follower
+    inline constexpr float kForbiddenCost = std::numeric_limits<float>::infinity();
+
+    // Greedy assignment: repeatedly commits the cheapest (row, column) pair, with every row already on a
+    // column making that column crowdingPenalty more expensive for the next one. assigned holds each row's
+    // previous column on entry, which it keeps on ties, and its new column or kUnassigned on return.
+    // A row whose pairs are all forbidden stays unassigned.
+    template <std::size_t Rows, std::size_t Columns>
+    void AssignGreedy(const std::array<std::array<float, Columns>, Rows>& costs, std::size_t columns, float crowdingPenalty, std::span<std::uint8_t> assigned) {
+        std::array<std::uint8_t, Columns> load{};
+        std::array<bool, Rows> done{};
+        std::array<std::uint8_t, Rows> previous{};
+        std::ranges::copy(assigned, previous.begin());
+        std::ranges::fill(assigned, kUnassigned);
+
+        for (std::size_t round = 0; round < assigned.size(); ++round) {
+            auto bestCost = kForbiddenCost;
+            std::size_t bestRow = 0;
+            std::size_t bestColumn = 0;
+
+            for (std::size_t i = 0; i < assigned.size(); ++i) {
+                if (done[i]) {
+                    continue;
+                }
+                for (std::size_t j = 0; j < columns; ++j) {
+                    if (std::isinf(costs[i][j])) {
+                        continue;
+                    }
+                    auto cost = costs[i][j] + crowdingPenalty * load[j];
+                    if (cost < bestCost || (cost == bestCost && previous[i] == j)) {
+                        bestCost = cost;
+                        bestRow = i;
+                        bestColumn = j;
+                    }
+                }
+            }
+
+            // Everyone left has nothing they may take
+            if (std::isinf(bestCost)) {
+                return;
+            }
+
+            done[bestRow] = true;
+            ++load[bestColumn];
+            assigned[bestRow] = static_cast<std::uint8_t>(bestColumn);
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// The names the class table and the class rules share, kept free of game types so the rule matcher
+// builds on its own
+namespace CombatClasses {
+    // Weapon the actor must have drawn in the right hand for the class to be active
+    enum class WeaponCondition : std::uint8_t {
+        kAny,
+        kBow,
+        kMelee,
+        kOneHanded,
+        kTwoHanded
+    };
+
+    using ClassID = std::uint16_t;
+    inline constexpr ClassID kNoClass = 0xFFFF;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "combat_class_table.h"
+#include "rule_matcher.h"
+
+// Rules that hand combat classes to any NPC, not just configured followers. Every predicate of
+// every rule is compiled into one bit; an actor is reduced to the set of bits it satisfies, and a
+// rule matches when all of its bits are set.
+namespace CombatClasses {
+    // A rule as written in the config. Form lists hold "FormID~Plugin" or EditorID strings;
+    // any entry in a list satisfies that predicate.
+    struct RawRule {
+        std::string name;
+        std::string className;
+        std::vector<std::string> factions;
+        std::vector<std::string> races;
+        std::vector<std::string> keywords;
+        std::uint16_t minLevel = 0;
+        std::uint16_t maxLevel = 0;
+        std::optional<WeaponCondition> weapon;
+    };
+
+    // Splits a comma separated config value into trimmed, non-empty entries
+    inline std::vector<std::string> SplitList(std::string_view text) {
+        std::vector<std::string> entries;
+        Text::Tokenizer(text, ","sv).ForEach([&](std::string_view entry) {
+            entry = Text::Trim(entry);
+            if (!entry.empty()) {
+                entries.emplace_back(entry);
+            }
+        });
+        return entries;
+    }
+
+    inline RE::TESForm* ResolveFormReference(std::string_view text) {
+        auto separator = text.find('~');
+        if (separator == std::string_view::npos) {
+            return RE::TESForm::LookupByEditorID(text);
+        }
+
+        std::uint32_t localFormID = 0;
+        auto formText = text.substr(0, separator);
+        if (std::from_chars(formText.data(), formText.data() + formText.size(), localFormID, 16).ec != std::errc{}) {
+            return nullptr;
+        }
+
+        auto dataHandler = RE::TESDataHandler::GetSingleton();
+        return dataHandler ? dataHandler->LookupForm(localFormID, text.substr(separator + 1)) : nullptr;
+    }
+
+    class RuleTable {
+    private:
+        RuleMatcher matcher;
+
+    public:
+        bool empty() const { return matcher.empty(); }
+        std::size_t size() const { return matcher.size(); }
+
+        // Resolves every form in the rules and assigns predicate bits. Game thread only.
+        void Compile(const std::vector<RawRule>& rawRules, const ClassTable& classTable) {
+            matcher.Clear();
+
+            for (const auto& rawRule : rawRules) {
+                auto classID = classTable.Find(rawRule.className);
+                if (classID == kNoClass) {
+                    logger::warn("Rule {}: unknown class '{}'", rawRule.name, rawRule.className);
+                    continue;
+                }
+
+                ResolvedRule rule{ rawRule.name, classID, {}, {}, {}, rawRule.minLevel, rawRule.maxLevel, rawRule.weapon };
+                bool valid = ResolveForms(rawRule, rawRule.factions, RE::FormType::Faction, rule.factions) &&
+                             ResolveForms(rawRule, rawRule.races, RE::FormType::Race, rule.races) &&
+                             ResolveForms(rawRule, rawRule.keywords, RE::FormType::Keyword, rule.keywords);
+
+                if (!valid || !matcher.Add(rule)) {
+                    logger::warn("Rule {} disabled", rawRule.name);
+                }
+            }
+
+            logger::info("Compiled {} class rules over {} predicates", matcher.size(), matcher.atoms());
+        }
+
+        // Class of the first rule the actor satisfies, or kNoClass
+        ClassID Match(RE::Actor* actor) const {
+            if (matcher.empty() || !actor) {
+                return kNoClass;
+            }
+            return Match(actor, EvaluateBase(actor->GetActorBase()));
+        }
+
+        // Same as above, starting from bits already computed for the actor's base
+        ClassID Match(RE::Actor* actor, const RuleBits& baseBits) const {
+            if (matcher.empty() || !actor) {
+                return kNoClass;
+            }
+            return matcher.Match(baseBits | EvaluateReference(actor));
+        }
+
+        // Bits that depend only on the base NPC: its factions, race and keywords. These are the same
+        // for every reference of the base, so callers may cache them.
+        RuleBits EvaluateBase(const RE::TESNPC* npc) const {
+            RuleBits bits;
+            if (!npc) {
+                return bits;
+            }
+
+            if (matcher.UsesFactions()) {
+                for (const auto& factionRank : npc->factions) {
+                    AddFaction(bits, factionRank.faction, factionRank.rank);
+                }
+            }
+
+            auto race = npc->race;
+            if (race && matcher.UsesRaces()) {
+                matcher.AddRace(bits, race->GetFormID());
+            }
+
+            if (matcher.UsesKeywords()) {
+                AddKeywords(bits, npc);
+                AddKeywords(bits, race);
+            }
+
+            return bits;
+        }
+
+    private:
+        // False when a non-empty list resolved to nothing: a predicate that can never be satisfied would
+        // silently disable the rule
+        static bool ResolveForms(const RawRule& rawRule, const std::vector<std::string>& references, RE::FormType formType, std::vector<RE::FormID>& formIDs) {
+            for (const auto& reference : references) {
+                auto form = ResolveFormReference(reference);
+                if (!form || form->GetFormType() != formType) {
+                    logger::warn("Rule {}: could not resolve '{}'", rawRule.name, reference);
+                    continue;
+                }
+                formIDs.push_back(form->GetFormID());
+            }
+            return references.empty() || !formIDs.empty();
+        }
+
+        // Bits that can differ between references of one base: faction changes, level and weapon
+        RuleBits EvaluateReference(RE::Actor* actor) const {
+            RuleBits bits;
+
+            // Factions joined at runtime; leaving a base faction is not tracked
+            if (matcher.UsesFactions()) {
+                if (auto changes = actor->extraList.GetByType<RE::ExtraFactionChanges>()) {
+                    for (const auto& factionRank : changes->factionChanges) {
+                        AddFaction(bits, factionRank.faction, factionRank.rank);
+                    }
+                }
+            }
+
+            if (matcher.UsesLevels()) {
+                matcher.AddLevel(bits, actor->GetLevel());
+            }
+
+            if (matcher.UsesWeapons()) {
+                auto rightHand = actor->GetEquippedObject(false);
+                auto weapon = rightHand ? rightHand->As<RE::TESObjectWEAP>() : nullptr;
+                matcher.AddWeapon(bits, [weapon](WeaponCondition condition) { return MatchesWeapon(condition, weapon); });
+            }
+
+            return bits;
+        }
+
+        void AddFaction(RuleBits& bits, const RE::TESFaction* faction, std::int8_t rank) const {
+            if (!faction || rank < 0) {
+                return;
+            }
+            matcher.AddFaction(bits, faction->GetFormID());
+        }
+
+        void AddKeywords(RuleBits& bits, const RE::BGSKeywordForm* keywordForm) const {
+            if (!keywordForm) {
+                return;
+            }
+            for (std::uint32_t i = 0; i < keywordForm->numKeywords; ++i) {
+                auto keyword = keywordForm->keywords[i];
+                if (!keyword) continue;
+                matcher.AddKeyword(bits, keyword->GetFormID());
+            }
+        }
+    };
+}
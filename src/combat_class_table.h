@@ -0,0 +1,142 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include "class_id.h"
+#include "modifier.h"
+#include "util.h"
+
+// Named combat classes from the config, compiled into one contiguous modifier array so applying
+// or removing a class is a single loop over (ActorValue, op, value) triples.
+namespace CombatClasses {
+    // Actor values the built-in improvement layers touch, resolved once by name
+    struct ImprovementValues {
+        RE::ActorValue marksman = RE::ActorValue::kNone;
+        RE::ActorValue attackAngleMult = RE::ActorValue::kNone;
+        RE::ActorValue aimOffsetV = RE::ActorValue::kNone;
+        RE::ActorValue aimSightedDelay = RE::ActorValue::kNone;
+        RE::ActorValue combatHealthRegenMult = RE::ActorValue::kNone;
+    };
+
+    inline const ImprovementValues& GetImprovementValues() {
+        static const ImprovementValues values = [] {
+            ImprovementValues resolved;
+            if (auto actorValueList = RE::ActorValueList::GetSingleton()) {
+                resolved.marksman = actorValueList->LookupActorValueByName("Marksman"sv);
+                resolved.attackAngleMult = actorValueList->LookupActorValueByName("attackAngleMult"sv);
+                resolved.aimOffsetV = actorValueList->LookupActorValueByName("aimOffsetV"sv);
+                resolved.aimSightedDelay = actorValueList->LookupActorValueByName("aimSightedDelay"sv);
+                resolved.combatHealthRegenMult = actorValueList->LookupActorValueByName("combatHealthRegenMult"sv);
+            }
+            return resolved;
+        }();
+        return values;
+    }
+
+    struct RawClass {
+        std::string name;
+        WeaponCondition condition = WeaponCondition::kAny;
+        std::vector<RawModifier> modifiers;
+    };
+
+    inline std::optional<WeaponCondition> ParseWeaponCondition(std::string_view text) {
+        if (Util::String::iEquals(text, "Any"sv)) return WeaponCondition::kAny;
+        if (Util::String::iEquals(text, "Bow"sv)) return WeaponCondition::kBow;
+        if (Util::String::iEquals(text, "Melee"sv)) return WeaponCondition::kMelee;
+        if (Util::String::iEquals(text, "OneHanded"sv)) return WeaponCondition::kOneHanded;
+        if (Util::String::iEquals(text, "TwoHanded"sv)) return WeaponCondition::kTwoHanded;
+        return std::nullopt;
+    }
+
+    inline bool MatchesWeapon(WeaponCondition condition, const RE::TESObjectWEAP* weapon) {
+        if (condition == WeaponCondition::kAny) {
+            return true;
+        }
+        if (!weapon) {
+            return false;
+        }
+
+        switch (weapon->GetWeaponType()) {
+        case RE::WEAPON_TYPE::kBow:
+        case RE::WEAPON_TYPE::kCrossbow:
+            return condition == WeaponCondition::kBow;
+        case RE::WEAPON_TYPE::kOneHandSword:
+        case RE::WEAPON_TYPE::kOneHandDagger:
+        case RE::WEAPON_TYPE::kOneHandAxe:
+        case RE::WEAPON_TYPE::kOneHandMace:
+            return condition == WeaponCondition::kMelee || condition == WeaponCondition::kOneHanded;
+        case RE::WEAPON_TYPE::kTwoHandSword:
+        case RE::WEAPON_TYPE::kTwoHandAxe:
+            return condition == WeaponCondition::kMelee || condition == WeaponCondition::kTwoHanded;
+        default:
+            return false;
+        }
+    }
+
+    class ClassTable {
+    public:
+        struct Profile {
+            std::string name;
+            std::uint32_t first = 0;
+            std::uint32_t count = 0;
+            WeaponCondition condition = WeaponCondition::kAny;
+        };
+
+    private:
+        std::vector<Modifier> modifiers;
+        std::vector<Profile> profiles;
+        std::unordered_map<std::string, ClassID, Text::IHash, Text::IEqual> ids;
+
+    public:
+        // Resolves actor value names and flattens every class into the shared modifier array. Game thread only.
+        void Compile(const std::vector<RawClass>& classes) {
+            modifiers.clear();
+            profiles.clear();
+            ids.clear();
+
+            auto actorValueList = RE::ActorValueList::GetSingleton();
+
+            for (const auto& rawClass : classes) {
+                Profile profile;
+                profile.name = rawClass.name;
+                profile.first = static_cast<std::uint32_t>(modifiers.size());
+                profile.condition = rawClass.condition;
+
+                for (const auto& rawModifier : rawClass.modifiers) {
+                    auto actorValue = actorValueList ? actorValueList->LookupActorValueByName(rawModifier.actorValue) : RE::ActorValue::kNone;
+                    if (actorValue == RE::ActorValue::kNone) {
+                        logger::warn("Class {}: unknown actor value '{}'", rawClass.name, rawModifier.actorValue);
+                        continue;
+                    }
+                    modifiers.push_back({ actorValue, rawModifier.op, rawModifier.value });
+                }
+
+                profile.count = static_cast<std::uint32_t>(modifiers.size()) - profile.first;
+                ids.insert_or_assign(profile.name, static_cast<ClassID>(profiles.size()));
+                profiles.push_back(std::move(profile));
+            }
+
+            logger::info("Compiled {} combat classes ({} modifiers)", profiles.size(), modifiers.size());
+        }
+
+        ClassID Find(std::string_view name) const {
+            auto it = ids.find(name);
+            return it != ids.end() ? it->second : kNoClass;
+        }
+
+        const Profile* GetProfile(ClassID id) const {
+            return id < profiles.size() ? &profiles[id] : nullptr;
+        }
+
+        std::span<const Modifier> GetModifiers(ClassID id) const {
+            auto profile = GetProfile(id);
+            if (!profile) {
+                return {};
+            }
+            return { modifiers.data() + profile->first, profile->count };
+        }
+
+        std::size_t size() const { return profiles.size(); }
+    };
+}
@@ -1,6 +1,16 @@
 #pragma once
 
+#include <random>
 #include "settings.h"
+#include "form_cache.h"
+#include "idle_queue.h"
+#include "target_allocator.h"
+#include "timing_wheel.h"
+#include "fixed_containers.h"
+#include "push_queue.h"
+#include "modifier_ledger.h"
+#include "telemetry.h"
+#include "util.h"
 
 // Add ActorValue enum if it's not defined
 namespace AV {
@@ -19,23 +29,74 @@ private:
     
     // Track actor state
     struct ActorState {
-        bool improvementsApplied = false;
-        bool hasSpecialBowBonus = false;
+        // Every actor value change goes through here, one layer per bonus source
+        CombatClasses::ModifierLedger ledger;
         bool swordKnockbackActive = false;
-        float originalMarksman = 0.0f;
-        float originalAttackAngleMult = 1.0f;
-        float originalAimOffsetV = 1.0f;
-        float originalAimSightedDelay = 0.25f;
-        float originalCombatHealthRegenMult = 1.0f;
         RE::FormID equippedBowID = 0;
         RE::FormID equippedSwordID = 0;
-        std::chrono::steady_clock::time_point lastKnockbackTime;
+        CombatClasses::ClassID classID = CombatClasses::kNoClass;
+        // Weapon profile whose knockback or stagger the strike timer fires
+        CombatClasses::ProfileID strikeProfile = CombatClasses::kNoProfile;
+        // Fires every knockback interval while the strike is active; in on-hit mode, runs out the cooldown instead
+        Timers::TimerID knockbackTimer = Timers::kNoTimer;
+        
+        bool HasStrikeWeapon() const { return equippedSwordID != 0 || strikeProfile != CombatClasses::kNoProfile; }
     };
     
     // Maps actor formIDs to their state
     std::unordered_map<RE::FormID, ActorState> actorStates;
     
+    // Probe over actorStates so events about untracked forms skip the hash lookup. Bits of removed actors
+    // linger until enough have piled up to rebuild.
+    FormIDFilter<4096> trackedFilter;
+    std::size_t untrackedSinceRebuild = 0;
+    
+    // Arguments for PushActorAway, reused for every knockback. The VM copies them out
+    // before DispatchMethodCall returns, so a single instance is enough.
+    class PushActorAwayArguments : public RE::BSScript::IFunctionArguments {
+    public:
+        RE::Actor* target = nullptr;
+        float magnitude = 0.0f;
+        
+        bool operator()(RE::BSScrapArray<RE::BSScript::Variable>& a_dst) const override {
+            a_dst.resize(2);
+            RE::BSScript::PackValue(std::addressof(a_dst[0]), target);
+            RE::BSScript::PackValue(std::addressof(a_dst[1]), magnitude);
+            return true;
+        }
+    };
+    
+    PushActorAwayArguments pushArguments;
+    
+    // Upper bound on targets a single area knockback can hit, whatever the config asks for
+    static constexpr std::size_t maxAreaTargets = 16;
+    
+    // Pushes collected during a tick and dispatched together by FlushPushes
+    PushQueue<RE::ActorHandle, 64> pendingPushes;
+    RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> noCallback;
+    FormatBuffer<256> notificationBuffer;
+    
+    // Rolls weapon profile proc chances
+    std::minstd_rand rng{ std::random_device{}() };
+    std::uniform_real_distribution<float> procRoll{ 0.0f, 1.0f };
+    
     CombatClassesManager() = default;
+    
+    ActorState& Track(RE::FormID formID) {
+        trackedFilter.Insert(formID);
+        return actorStates[formID];
+    }
+    
+    void Untrack(std::unordered_map<RE::FormID, ActorState>::iterator it) {
+        actorStates.erase(it);
+        if (++untrackedSinceRebuild > 64 + actorStates.size()) {
+            trackedFilter.Clear();
+            for (const auto& [formID, state] : actorStates) {
+                trackedFilter.Insert(formID);
+            }
+            untrackedSinceRebuild = 0;
+        }
+    }
 
 public:
     static CombatClassesManager* GetSingleton() {
@@ -63,43 +124,84 @@ public:
                 auto actor = RE::TESForm::LookupByID<RE::Actor>(formID);
                 if (actor && actor->Is3DLoaded()) {
                     logger::info("Initializing follower: {}", name);
-                    ApplyAccuracyImprovements(actor);
-                    
-                    // Check if they already have equipment
-                    auto rightHand = actor->GetEquippedObject(false);
-                    if (rightHand) {
-                        auto weapon = rightHand->As<RE::TESObjectWEAP>();
-                        if (weapon) {
-                            HandleWeaponEquipped(actor, weapon);
-                        }
-                    }
+                    InitializeActor(actor);
                 }
             }
         }
     }
     
+    // Applies improvements and picks up whatever the actor already has equipped
+    void InitializeActor(RE::Actor* actor) {
+        if (!actor) return;
+        
+        auto& state = Track(actor->GetFormID());
+        ApplyAccuracyImprovements(actor, state);
+        ApplyConfiguredClass(actor, state);
+        
+        // Check if they already have equipment
+        auto rightHand = actor->GetEquippedObject(false);
+        if (rightHand) {
+            auto weapon = rightHand->As<RE::TESObjectWEAP>();
+            if (weapon) {
+                HandleWeaponEquipped(actor, state, weapon);
+            }
+        }
+        
+        FlushValues(actor, state);
+    }
+    
+    // Switches an actor to a named class from the config, or clears it with "None"
+    bool ApplyClass(RE::Actor* actor, std::string_view className) {
+        if (!actor) return false;
+        
+        auto classID = CombatClasses::kNoClass;
+        if (!Util::String::iEquals(className, "None"sv)) {
+            classID = Settings::GetSingleton()->GetClassTable().Find(className);
+            if (classID == CombatClasses::kNoClass) {
+                logger::warn("Unknown combat class '{}' requested for {}", className, actor->GetName());
+                return false;
+            }
+        }
+        
+        auto& state = Track(actor->GetFormID());
+        SetClass(actor, state, classID);
+        FlushValues(actor, state);
+        return true;
+    }
+    
     void OnActorEquip(RE::Actor* actor, RE::TESBoundObject* object) {
         if (!actor || !object) return;
         
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID())) return;
-        
         auto weapon = object->As<RE::TESObjectWEAP>();
-        if (weapon) {
-            HandleWeaponEquipped(actor, weapon);
+        if (!weapon) return;
+        
+        auto settings = Settings::GetSingleton();
+        if (settings->IsFollower(actor->GetFormID())) {
+            auto& state = Track(actor->GetFormID());
+            HandleWeaponEquipped(actor, state, weapon);
+            FlushValues(actor, state);
+        } else if (auto it = actorStates.find(actor->GetFormID()); it != actorStates.end()) {
+            // NPCs classed by a rule only get their class toggled, not the follower bonuses
+            RefreshClass(actor, it->second, weapon);
+            FlushValues(actor, it->second);
         }
     }
     
     void OnActorUnequip(RE::Actor* actor, RE::TESBoundObject* object) {
         if (!actor || !object) return;
         
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID())) return;
-        
         auto weapon = object->As<RE::TESObjectWEAP>();
-        if (weapon) {
-            HandleWeaponUnequipped(actor, weapon);
+        if (!weapon) return;
+        
+        auto it = actorStates.find(actor->GetFormID());
+        if (it == actorStates.end()) return;
+        
+        if (Settings::GetSingleton()->IsFollower(actor->GetFormID())) {
+            HandleWeaponUnequipped(actor, it->second, weapon);
+        } else {
+            RefreshClass(actor, it->second, nullptr);
         }
+        FlushValues(actor, it->second);
     }
     
     void OnActorLoad(RE::Actor* actor) {
@@ -109,263 +211,385 @@ public:
         if (settings->IsFollower(actor->GetFormID()) && settings->IsFollowerEnabled(actor->GetFormID())) {
             logger::info("Follower loaded: {}", actor->GetName());
             
+            auto& state = Track(actor->GetFormID());
             if (settings->GetAutoApplyImprovements()) {
-                ApplyAccuracyImprovements(actor);
+                ApplyAccuracyImprovements(actor, state);
             }
+            ApplyConfiguredClass(actor, state);
+            FlushValues(actor, state);
+        } else if (!settings->IsFollower(actor->GetFormID()) && !actor->IsPlayerRef()) {
+            // Any other NPC gets the class of the first rule it matches, if there is one
+            auto classID = CombatClasses::FormCache::GetSingleton()->GetRuleClass(actor);
+            if (classID == CombatClasses::kNoClass) return;
+            
+            auto& state = Track(actor->GetFormID());
+            SetClass(actor, state, classID);
+            FlushValues(actor, state);
         }
     }
     
+    // Whether the manager holds state for this actor, either as a follower or through a class rule
+    bool IsTracked(RE::FormID formID) const {
+        return trackedFilter.MayContain(formID) && actorStates.contains(formID);
+    }
+    
     void OnActorUnload(RE::Actor* actor) {
         if (!actor) return;
         
-        auto settings = Settings::GetSingleton();
-        if (settings->IsFollower(actor->GetFormID())) {
+        auto it = actorStates.find(actor->GetFormID());
+        if (it == actorStates.end()) return;
+        
+        if (Settings::GetSingleton()->IsFollower(actor->GetFormID())) {
             logger::info("Follower unloaded: {}", actor->GetName());
-            
-            RemoveAccuracyImprovements(actor);
-            RemoveBowBonus(actor);
-            RemoveSpecialBowBonus(actor);
-            StopSwordKnockback(actor);
-            
-            // Remove from tracking
-            actorStates.erase(actor->GetFormID());
+        }
+        
+        // Only layers that were actually applied get reverted
+        StopSwordKnockback(actor);
+        it->second.ledger.Reset();
+        FlushValues(actor, it->second);
+        
+        // Remove from tracking
+        Untrack(it);
+    }
+    
+    // Drops state for an actor that is gone without reverting anything on it. Cheap for untracked forms.
+    void Forget(RE::FormID formID) {
+        if (!trackedFilter.MayContain(formID)) {
+            return;
+        }
+        if (auto it = actorStates.find(formID); it != actorStates.end()) {
+            Timers::Scheduler::GetSingleton()->Cancel(Timers::Clock::kGame, it->second.knockbackTimer);
+            Untrack(it);
+        }
+    }
+    
+    // Visits every tracked actor's ledger, for the co-save
+    template <class Visit>
+    void ForEachLedger(Visit&& visit) const {
+        for (const auto& [formID, state] : actorStates) {
+            visit(formID, state.ledger);
         }
     }
     
-    void Update(RE::Actor* actor) {
+    // Forgets every tracked actor without reverting anything. For a load or new game, where the actors the
+    // state was built for are gone and the new session's values come from the save.
+    void Reset() {
+        actorStates.clear();
+        trackedFilter.Clear();
+        untrackedSinceRebuild = 0;
+        pendingPushes.clear();
+    }
+    
+    // Sword knockback only runs while the follower is fighting
+    void OnCombatStart(RE::Actor* actor) {
         if (!actor) return;
         
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID()) || !settings->IsFollowerEnabled(actor->GetFormID())) {
+        auto it = actorStates.find(actor->GetFormID());
+        if (it != actorStates.end() && it->second.HasStrikeWeapon()) {
+            StartSwordKnockback(actor);
+        }
+    }
+    
+    void OnCombatEnd(RE::Actor* actor) {
+        if (!actor) return;
+        
+        StopSwordKnockback(actor);
+    }
+    
+    // Dispatches queued knockbacks, at most the configured number per frame. Called once per tick after every actor updated.
+    void FlushPushes() {
+        if (pendingPushes.empty()) {
             return;
         }
         
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        if (it == actorStates.end()) {
+        auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton();
+        if (!vm) {
+            pendingPushes.clear();
             return;
         }
         
-        auto& state = it->second;
+        const auto& className = FixedStrings::Get(FixedStrings::ID::kObjectReference);
+        const auto& funcName = FixedStrings::Get(FixedStrings::ID::kPushActorAway);
         
-        // Handle sword knockback
-        if (state.swordKnockbackActive && state.equippedSwordID != 0) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - state.lastKnockbackTime).count();
+        auto policy = vm->GetObjectHandlePolicy();
+        pendingPushes.Flush(Settings::GetSingleton()->GetMaxPushesPerFrame(), [&](const auto& push) {
+            auto source = push.source.get();
+            auto target = push.target.get();
+            if (!source || !target || target->IsDead()) {
+                return false;
+            }
             
-            if (elapsed >= settings->GetKnockbackInterval()) {
-                // Time to do knockback
-                HandleSwordKnockback(actor);
-                state.lastKnockbackTime = now;
+            auto handle = policy->GetHandleForObject(static_cast<RE::VMTypeID>(source->GetFormType()), source.get());
+            if (handle == policy->EmptyHandle()) {
+                return false;
             }
-        }
+            pushArguments.target = target.get();
+            pushArguments.magnitude = push.magnitude;
+            vm->DispatchMethodCall(handle, className, funcName, &pushArguments, noCallback);
+            return true;
+        });
+        
+        logger::debug("Pushes: {} dispatched, {} deferred, {} dropped in total", pendingPushes.GetDispatched(),
+            pendingPushes.GetDeferred(), pendingPushes.GetDropped());
+    }
+    
+    // Drops queued knockbacks, e.g. when the last fight ends
+    void ClearPendingPushes() {
+        pendingPushes.clear();
     }
     
 private:
-    void HandleWeaponEquipped(RE::Actor* actor, RE::TESObjectWEAP* weapon) {
-        auto settings = Settings::GetSingleton();
+    using Ledger = CombatClasses::ModifierLedger;
+    
+    // Writes every actor value whose layered result changed since the last flush
+    void FlushValues(RE::Actor* actor, ActorState& state) {
+        if (!state.ledger.IsDirty()) {
+            return;
+        }
+        
+        auto values = actor->AsActorValueOwner();
+        auto writes = state.ledger.Flush(
+            [values](RE::ActorValue actorValue) { return values->GetBaseActorValue(actorValue); },
+            [values](RE::ActorValue actorValue, float value) { values->SetBaseActorValue(actorValue, value); });
+        
+        logger::debug("Flushed {} actor values for {}", writes, actor->GetName());
+    }
+    
+    void HandleWeaponEquipped(RE::Actor* actor, ActorState& state, RE::TESObjectWEAP* weapon) {
+        const auto& info = CombatClasses::FormCache::GetSingleton()->GetWeapon(weapon);
         auto weaponID = weapon->GetFormID();
-        auto actorID = actor->GetFormID();
+        std::uint64_t bonuses = 0;
         
-        // Get or create actor state
-        auto& state = actorStates[actorID];
+        RefreshClass(actor, state, weapon);
         
         // Check weapon type
-        if (weapon->GetWeaponType() == RE::WEAPON_TYPE::kBow) {
+        if (info.IsBow()) {
             // Apply bow bonus
-            ApplyBowBonus(actor);
+            ApplyBowBonus(actor, state);
             state.equippedBowID = weaponID;
+            ++bonuses;
             
             // Check if it's a special bow
-            if (settings->IsSpecialBow(weaponID)) {
-                ApplySpecialBowBonus(actor);
+            if (info.IsSpecialBow()) {
+                ApplySpecialBowBonus(actor, state);
+                ++bonuses;
                 
                 // Notify player if the follower is player's follower
                 if (actor->IsPlayerTeammate()) {
                     auto name = weapon->GetName();
-                    RE::DebugNotification(fmt::format("{}'s Improved Aim Activated", name).c_str());
+                    RE::DebugNotification(notificationBuffer.Format("{}'s Improved Aim Activated", name));
                 }
             }
-        } else if (settings->IsSpecialSword(weaponID)) {
-            // It's a special sword, start the knockback effect
-            StartSwordKnockback(actor);
+        } else if (info.IsSpecialSword()) {
+            // It's a special sword, the knockback effect arms once the follower is in combat
             state.equippedSwordID = weaponID;
+            ++bonuses;
+            if (actor->IsInCombat()) {
+                StartSwordKnockback(actor);
+            }
             
             // Notify player if the follower is player's follower
             if (actor->IsPlayerTeammate()) {
                 auto name = weapon->GetName();
-                RE::DebugNotification(fmt::format("{}'s Knockback Power Activated", name).c_str());
+                RE::DebugNotification(notificationBuffer.Format("{}'s Knockback Power Activated", name));
             }
         }
-    }
-    
-    void HandleWeaponUnequipped(RE::Actor* actor, RE::TESObjectWEAP* weapon) {
-        auto settings = Settings::GetSingleton();
-        auto weaponID = weapon->GetFormID();
-        auto actorID = actor->GetFormID();
         
-        auto it = actorStates.find(actorID);
-        if (it == actorStates.end()) {
-            return;
+        if (info.profile != CombatClasses::kNoProfile) {
+            ApplyWeaponProfile(actor, state, info.profile);
+            ++bonuses;
         }
         
-        auto& state = it->second;
+        if (bonuses > 0) {
+            Telemetry::Add(Telemetry::Counter::kBonusesApplied, actor->GetFormID(), weaponID, bonuses);
+        }
+    }
+    
+    void HandleWeaponUnequipped(RE::Actor* actor, ActorState& state, RE::TESObjectWEAP* weapon) {
+        const auto& info = CombatClasses::FormCache::GetSingleton()->GetWeapon(weapon);
+        std::uint64_t bonuses = 0;
+        
+        RefreshClass(actor, state, nullptr);
         
         // Check weapon type
-        if (weapon->GetWeaponType() == RE::WEAPON_TYPE::kBow) {
+        if (info.IsBow()) {
             // Remove bow bonuses
-            RemoveBowBonus(actor);
-            
-            // Check if it's the special bow
-            if (settings->IsSpecialBow(weaponID)) {
-                RemoveSpecialBowBonus(actor);
-            }
+            bonuses += state.ledger.HasLayer(Ledger::kBow) + state.ledger.HasLayer(Ledger::kSpecialBow);
+            RemoveBowBonus(actor, state);
+            RemoveSpecialBowBonus(actor, state);
             
             state.equippedBowID = 0;
-        } else if (settings->IsSpecialSword(weaponID)) {
-            // It's the special sword, stop the knockback effect
-            StopSwordKnockback(actor);
+        } else if (info.IsSpecialSword()) {
+            // It's the special sword, stop the knockback effect unless a profile still drives it
+            bonuses += state.equippedSwordID != 0;
             state.equippedSwordID = 0;
+            if (!state.HasStrikeWeapon()) {
+                StopSwordKnockback(actor);
+            }
         }
-    }
-    
-    void ApplyAccuracyImprovements(RE::Actor* actor) {
-        if (!actor) return;
         
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
+        if (info.profile != CombatClasses::kNoProfile) {
+            RemoveWeaponProfile(actor, state);
+            ++bonuses;
+        }
         
+        if (bonuses > 0) {
+            Telemetry::Add(Telemetry::Counter::kBonusesRemoved, actor->GetFormID(), weapon->GetFormID(), bonuses);
+        }
+    }
+    
+    void ApplyAccuracyImprovements(RE::Actor* actor, ActorState& state) {
         // If already applied, return
-        if (it != actorStates.end() && it->second.improvementsApplied) {
+        if (state.ledger.HasLayer(Ledger::kBaseImprovement)) {
             return;
         }
         
-        // Get settings
         auto settings = Settings::GetSingleton();
+        const auto& av = CombatClasses::GetImprovementValues();
+        using enum CombatClasses::ModifierOp;
         
-        // Create state for this actor if it doesn't exist
-        auto& state = actorStates[actorID];
-        
-        // Store original values
-        state.originalMarksman = actor->GetActorValueByName("Marksman");
-        state.originalAttackAngleMult = actor->GetActorValueByName("attackAngleMult");
-        state.originalAimOffsetV = actor->GetActorValueByName("aimOffsetV");
-        state.originalAimSightedDelay = actor->GetActorValueByName("aimSightedDelay");
-        state.originalCombatHealthRegenMult = actor->GetActorValueByName("combatHealthRegenMult");
-        
-        // Apply improvements
-        if (actor->GetActorValueByName("Marksman") < state.originalMarksman + settings->GetBaseAccuracyBonus()) {
-            actor->SetActorValueByName("Marksman", state.originalMarksman + settings->GetBaseAccuracyBonus());
-        }
-        
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult());
-        actor->SetActorValueByName("aimOffsetV", settings->GetAimOffsetV());
-        actor->SetActorValueByName("aimSightedDelay", settings->GetAimSightedDelay());
-        actor->SetActorValueByName("combatHealthRegenMult", 2.0f);
-        
-        state.improvementsApplied = true;
+        state.ledger.SetLayer(Ledger::kBaseImprovement, {
+            { av.marksman, kAdd, settings->GetBaseAccuracyBonus() },
+            { av.attackAngleMult, kSet, settings->GetAttackAngleMult() },
+            { av.aimOffsetV, kSet, settings->GetAimOffsetV() },
+            { av.aimSightedDelay, kSet, settings->GetAimSightedDelay() },
+            { av.combatHealthRegenMult, kSet, settings->GetCombatHealthRegenMult() },
+        });
         
         // Notify player if the follower is player's follower
         if (actor->IsPlayerTeammate()) {
-            RE::DebugNotification(fmt::format("{}'s Accuracy Improvements Applied", actor->GetName()).c_str());
+            RE::DebugNotification(notificationBuffer.Format("{}'s Accuracy Improvements Applied", actor->GetName()));
         }
         
         logger::info("Applied accuracy improvements to {}", actor->GetName());
     }
     
-    void RemoveAccuracyImprovements(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        // If not applied, return
-        if (it == actorStates.end() || !it->second.improvementsApplied) {
-            return;
-        }
-        
-        auto& state = it->second;
-        
-        // Restore original values
-        actor->SetActorValueByName("Marksman", state.originalMarksman);
-        actor->SetActorValueByName("attackAngleMult", state.originalAttackAngleMult);
-        actor->SetActorValueByName("aimOffsetV", state.originalAimOffsetV);
-        actor->SetActorValueByName("aimSightedDelay", state.originalAimSightedDelay);
-        actor->SetActorValueByName("combatHealthRegenMult", state.originalCombatHealthRegenMult);
-        
-        state.improvementsApplied = false;
-        
-        logger::info("Removed accuracy improvements from {}", actor->GetName());
-    }
-    
-    void ApplyBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
+    void ApplyBowBonus(RE::Actor* actor, ActorState& state) {
         auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", settings->GetBowAccuracyBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.8f);
+        const auto& av = CombatClasses::GetImprovementValues();
+        using enum CombatClasses::ModifierOp;
+        
+        state.ledger.SetLayer(Ledger::kBow, {
+            { av.marksman, kAdd, settings->GetBowAccuracyBonus() },
+            { av.attackAngleMult, kMultiply, settings->GetBowAttackAngleScale() },
+        });
         
         logger::info("Applied bow bonus to {}", actor->GetName());
     }
     
-    void RemoveBowBonus(RE::Actor* actor) {
-        if (!actor) return;
+    void RemoveBowBonus(RE::Actor* actor, ActorState& state) {
+        if (!state.ledger.HasLayer(Ledger::kBow)) {
+            return;
+        }
         
-        auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", -settings->GetBowAccuracyBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult());
+        state.ledger.ClearLayer(Ledger::kBow);
         
         logger::info("Removed bow bonus from {}", actor->GetName());
     }
     
-    void ApplySpecialBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
+    void ApplySpecialBowBonus(RE::Actor* actor, ActorState& state) {
         // If already applied, return
-        if (it != actorStates.end() && it->second.hasSpecialBowBonus) {
+        if (state.ledger.HasLayer(Ledger::kSpecialBow)) {
             return;
         }
         
         auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", settings->GetSpecialBowBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.6f);
+        const auto& av = CombatClasses::GetImprovementValues();
+        using enum CombatClasses::ModifierOp;
         
-        // Update state
-        auto& state = actorStates[actorID];
-        state.hasSpecialBowBonus = true;
+        // The special scale replaces the regular bow scale rather than stacking with it
+        state.ledger.SetLayer(Ledger::kSpecialBow, {
+            { av.marksman, kAdd, settings->GetSpecialBowBonus() },
+            { av.attackAngleMult, kSet, settings->GetAttackAngleMult() * settings->GetSpecialBowAttackAngleScale() },
+        });
         
         logger::info("Applied special bow bonus to {}", actor->GetName());
     }
     
-    void RemoveSpecialBowBonus(RE::Actor* actor) {
-        if (!actor) return;
+    void RemoveSpecialBowBonus(RE::Actor* actor, ActorState& state) {
+        // If not applied, return
+        if (!state.ledger.HasLayer(Ledger::kSpecialBow)) {
+            return;
+        }
         
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
+        state.ledger.ClearLayer(Ledger::kSpecialBow);
         
-        // If not applied, return
-        if (it == actorStates.end() || !it->second.hasSpecialBowBonus) {
+        logger::info("Removed special bow bonus from {}", actor->GetName());
+    }
+    
+    void ApplyWeaponProfile(RE::Actor* actor, ActorState& state, CombatClasses::ProfileID profileID) {
+        auto profile = Settings::GetSingleton()->GetWeaponProfiles().GetProfile(profileID);
+        if (!profile) {
             return;
         }
         
+        if (profile->accuracy != 0.0f) {
+            const auto& av = CombatClasses::GetImprovementValues();
+            state.ledger.SetLayer(Ledger::kWeaponProfile, { { av.marksman, CombatClasses::ModifierOp::kAdd, profile->accuracy } });
+        } else {
+            state.ledger.ClearLayer(Ledger::kWeaponProfile);
+        }
+        
+        state.strikeProfile = profile->HasStrikeEffect() ? profileID : CombatClasses::kNoProfile;
+        if (state.strikeProfile != CombatClasses::kNoProfile && actor->IsInCombat()) {
+            StartSwordKnockback(actor);
+        }
+        
+        logger::info("Applied weapon profile {} to {}", profile->name, actor->GetName());
+    }
+    
+    void RemoveWeaponProfile(RE::Actor* actor, ActorState& state) {
+        state.ledger.ClearLayer(Ledger::kWeaponProfile);
+        state.strikeProfile = CombatClasses::kNoProfile;
+        if (!state.HasStrikeWeapon()) {
+            StopSwordKnockback(actor);
+        }
+    }
+    
+    // A class set on the follower entry wins over the class rules
+    void ApplyConfiguredClass(RE::Actor* actor, ActorState& state) {
         auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", -settings->GetSpecialBowBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.8f);
+        auto classID = settings->GetFollowerClass(actor->GetFormID());
+        if (classID == CombatClasses::kNoClass) {
+            classID = CombatClasses::FormCache::GetSingleton()->GetRuleClass(actor);
+        }
+        if (classID != CombatClasses::kNoClass) {
+            SetClass(actor, state, classID);
+        }
+    }
+    
+    void SetClass(RE::Actor* actor, ActorState& state, CombatClasses::ClassID classID) {
+        if (state.classID == classID) {
+            return;
+        }
         
-        // Update state
-        it->second.hasSpecialBowBonus = false;
+        state.ledger.ClearLayer(Ledger::kClass);
+        state.classID = classID;
         
-        logger::info("Removed special bow bonus from {}", actor->GetName());
+        auto rightHand = actor->GetEquippedObject(false);
+        RefreshClass(actor, state, rightHand ? rightHand->As<RE::TESObjectWEAP>() : nullptr);
+    }
+    
+    // Activates or deactivates the actor's class depending on its weapon condition
+    void RefreshClass(RE::Actor* actor, ActorState& state, const RE::TESObjectWEAP* weapon) {
+        const auto& table = Settings::GetSingleton()->GetClassTable();
+        auto profile = table.GetProfile(state.classID);
+        bool shouldBeActive = profile && CombatClasses::MatchesWeapon(profile->condition, weapon);
+        
+        if (shouldBeActive && !state.ledger.HasLayer(Ledger::kClass)) {
+            state.ledger.SetLayer(Ledger::kClass, table.GetModifiers(state.classID));
+            logger::info("Applied class {} to {}", profile->name, actor->GetName());
+        } else if (!shouldBeActive && state.ledger.HasLayer(Ledger::kClass)) {
+            state.ledger.ClearLayer(Ledger::kClass);
+            logger::info("Removed class from {}", actor->GetName());
+        }
     }
     
     void StartSwordKnockback(RE::Actor* actor) {
         if (!actor) return;
         
         auto actorID = actor->GetFormID();
-        auto& state = actorStates[actorID];
+        auto& state = Track(actorID);
         
         // If already active, return
         if (state.swordKnockbackActive) {
@@ -373,7 +597,10 @@ private:
         }
         
         state.swordKnockbackActive = true;
-        state.lastKnockbackTime = std::chrono::steady_clock::now();
+        // On-hit strikes wait for the follower's hits instead
+        if (!Settings::GetSingleton()->GetStrikeOnHit()) {
+            state.knockbackTimer = ScheduleKnockback(actor->GetHandle());
+        }
         
         logger::info("Started sword knockback for {}", actor->GetName());
     }
@@ -384,72 +611,220 @@ private:
         auto actorID = actor->GetFormID();
         auto it = actorStates.find(actorID);
         
-        if (it != actorStates.end()) {
+        if (it != actorStates.end() && it->second.swordKnockbackActive) {
             it->second.swordKnockbackActive = false;
+            Timers::Scheduler::GetSingleton()->Cancel(Timers::Clock::kGame, it->second.knockbackTimer);
+            it->second.knockbackTimer = Timers::kNoTimer;
             logger::info("Stopped sword knockback for {}", actor->GetName());
         }
     }
     
-    void HandleSwordKnockback(RE::Actor* actor) {
+    // Knockback runs on game time, so menus and pauses don't count toward the interval
+    Timers::TimerID ScheduleKnockback(RE::ActorHandle handle) {
+        auto interval = std::chrono::duration<float>(Settings::GetSingleton()->GetKnockbackInterval());
+        return Timers::Scheduler::GetSingleton()->Schedule(Timers::Clock::kGame, interval, [this, handle]() {
+            OnKnockbackTimer(handle);
+        });
+    }
+    
+    void OnKnockbackTimer(RE::ActorHandle handle) {
+        auto actor = handle.get();
         if (!actor) return;
         
+        auto it = actorStates.find(actor->GetFormID());
+        if (it == actorStates.end() || !it->second.swordKnockbackActive) {
+            return;
+        }
+        
+        auto& state = it->second;
         auto settings = Settings::GetSingleton();
         
-        // Find nearest enemy
-        auto nearestEnemy = GetNearestEnemy(actor);
-        if (nearestEnemy && !nearestEnemy->IsDead() && nearestEnemy->IsHostileToActor(actor)) {
-            // Apply knockback effect - using Skyrim's native PushActorAway function
-            // We need to access it through the game's script system
-            RE::TESForm* gameObj = RE::TESForm::LookupByID(0x14);  // Game's formID
-            if (gameObj) {
-                auto vm = SKSE::GetPapyrusInterface()->GetVirtualMachine();
-                if (vm) {
-                    // Create argument list
-                    RE::TESObjectREFR* source = actor;
-                    RE::TESObjectREFR* target = nearestEnemy;
-                    float magnitude = settings->GetKnockbackMagnitude();
-                    
-                    RE::BSFixedString funcName("PushActorAway");
-                    RE::BSFixedString objName("Game");
-                    
-                    // Call the function
-                    std::vector<RE::BSScript::Variable> args;
-                    
-                    RE::BSScript::Variable targetVar;
-                    targetVar.SetObject(target);
-                    args.push_back(targetVar);
-                    
-                    RE::BSScript::Variable sourceVar;
-                    sourceVar.SetObject(source);
-                    args.push_back(sourceVar);
-                    
-                    RE::BSScript::Variable magVar;
-                    magVar.SetFloat(magnitude);
-                    args.push_back(magVar);
-                    
-                    auto nullHandle = RE::BSScript::IObjectHandlePolicy::InvalidHandle;
-                    
-                    vm->SendEvent(nullHandle, objName.c_str(), funcName.c_str(), args);
-                }
+        // Switched to on-hit strikes by a settings reload
+        if (settings->GetStrikeOnHit()) {
+            state.knockbackTimer = Timers::kNoTimer;
+            return;
+        }
+        state.knockbackTimer = ScheduleKnockback(handle);
+        
+        if (!settings->IsFollower(actor->GetFormID()) || !settings->IsFollowerEnabled(actor->GetFormID())) {
+            return;
+        }
+        if (state.HasStrikeWeapon() && actor->Is3DLoaded()) {
+            HandleSwordKnockback(actor.get(), state);
+        }
+    }
+    
+    // A registered follower hit victim with weaponID. The hit sink only calls this for weapons that pass the
+    // strike weapon filter, so most of the world's hits never get here.
+    void OnStrikeHit(RE::Actor* actor, RE::Actor* victim, RE::FormID weaponID) {
+        auto settings = Settings::GetSingleton();
+        if (!settings->GetStrikeOnHit()) {
+            return;
+        }
+        
+        auto it = actorStates.find(actor->GetFormID());
+        if (it == actorStates.end() || !it->second.swordKnockbackActive) {
+            return;
+        }
+        
+        // The filter can let other weapons through; only the one driving the strike counts
+        auto& state = it->second;
+        if (weaponID != state.equippedSwordID &&
+            (state.strikeProfile == CombatClasses::kNoProfile || settings->GetWeaponProfiles().FindID(weaponID) != state.strikeProfile)) {
+            return;
+        }
+        
+        // At most one strike per knockback interval, on game time like the timed strikes
+        auto scheduler = Timers::Scheduler::GetSingleton();
+        if (scheduler->Get(Timers::Clock::kGame).IsScheduled(state.knockbackTimer)) {
+            return;
+        }
+        if (HandleSwordKnockback(actor, state, victim)) {
+            auto interval = std::chrono::duration<float>(settings->GetKnockbackInterval());
+            state.knockbackTimer = scheduler->Schedule(Timers::Clock::kGame, interval, nullptr);
+        }
+    }
+    
+    // Returns whether the strike landed on anyone. struck, when given, is the enemy a hit just landed on.
+    bool HandleSwordKnockback(RE::Actor* actor, const ActorState& state, RE::Actor* struck = nullptr) {
+        if (!actor) return false;
+        
+        auto settings = Settings::GetSingleton();
+        auto knockback = settings->GetKnockbackMagnitude();
+        auto stagger = 0.0f;
+        
+        // A profile weapon brings its own effect, which may only land some of the time
+        if (auto profile = settings->GetWeaponProfiles().GetProfile(state.strikeProfile)) {
+            if (profile->procChance < 1.0f && procRoll(rng) >= profile->procChance) {
+                return false;
+            }
+            knockback = profile->knockback;
+            stagger = profile->stagger;
+        }
+        
+        // Either every hostile in the area or a single enemy: the one just hit, else the nearest
+        FixedVector<RE::Actor*, maxAreaTargets> targets;
+        if (settings->GetKnockbackRadius() > 0.0f) {
+            CollectAreaTargets(actor, targets);
+        } else if (auto enemy = struck ? struck : GetNearestEnemy(actor); enemy && !enemy->IsDead() && enemy->IsHostileToActor(actor)) {
+            targets.push_back(enemy);
+        }
+        if (targets.empty()) {
+            return false;
+        }
+        
+        for (auto target : targets) {
+            if (stagger > 0.0f) {
+                StaggerTarget(actor, target, stagger);
+            }
+            if (knockback > 0.0f) {
+                QueuePush(actor, target, knockback);
+            }
+        }
+        
+        auto weaponID = state.equippedSwordID;
+        if (!weaponID) {
+            auto weapon = actor->GetEquippedObject(false);
+            weaponID = weapon ? weapon->GetFormID() : 0;
+        }
+        if (stagger > 0.0f) {
+            Telemetry::Add(Telemetry::Counter::kStaggers, actor->GetFormID(), weaponID, targets.size());
+        }
+        if (knockback > 0.0f) {
+            Telemetry::Add(Telemetry::Counter::kKnockbacks, actor->GetFormID(), weaponID, targets.size());
+        }
+        
+        // Notify player if the follower is player's teammate
+        if (knockback > 0.0f && actor->IsPlayerTeammate()) {
+            auto weapon = actor->GetEquippedObject(false);
+            if (weapon) {
+                auto name = weapon->GetName();
+                RE::DebugNotification(notificationBuffer.Format("{} unleashes a powerful knockback!", name));
+            }
+        }
+        
+        logger::info("{} performed knockback on {} targets", actor->GetName(), targets.size());
+        return true;
+    }
+    
+    void QueuePush(RE::Actor* source, RE::Actor* target, float magnitude) {
+        // Two followers hitting the same enemy in one frame would only stack the ragdoll
+        pendingPushes.Queue(source->GetHandle(), target->GetHandle(), magnitude);
+    }
+    
+    // Hostiles among the high process actors within the knockback radius and cone, nearest first
+    template <std::size_t N>
+    void CollectAreaTargets(RE::Actor* actor, FixedVector<RE::Actor*, N>& targets) {
+        auto processLists = RE::ProcessLists::GetSingleton();
+        if (!processLists) {
+            return;
+        }
+        
+        auto settings = Settings::GetSingleton();
+        auto radius = settings->GetKnockbackRadius();
+        auto radiusSquared = radius * radius;
+        auto halfCone = settings->GetKnockbackConeAngle() * 0.5f;
+        auto origin = actor->GetPosition();
+        
+        struct Candidate {
+            RE::Actor* actor;
+            float distanceSquared;
+        };
+        FixedVector<Candidate, 64> candidates;
+        
+        for (auto& handle : processLists->highActorHandles) {
+            auto candidate = handle.get();
+            if (!candidate || candidate.get() == actor || candidate->IsDead()) {
+                continue;
             }
             
-            // Notify player if the follower is player's teammate
-            if (actor->IsPlayerTeammate()) {
-                auto weapon = actor->GetEquippedObject(false);
-                if (weapon) {
-                    auto name = weapon->GetName();
-                    RE::DebugNotification(fmt::format("{} unleashes a powerful knockback!", name).c_str());
+            auto distanceSquared = origin.GetSquaredDistance(candidate->GetPosition());
+            if (distanceSquared > radiusSquared) {
+                continue;
+            }
+            if (halfCone < 180.0f && std::abs(actor->GetHeadingAngle(candidate->GetPosition(), false)) > halfCone) {
+                continue;
+            }
+            if (!candidate->IsHostileToActor(actor)) {
+                continue;
+            }
+            if (!candidates.push_back({ candidate.get(), distanceSquared })) {
+                // Full: keep the nearest ones, whatever order the process list hands them out in
+                auto farthest = std::ranges::max_element(candidates, {}, &Candidate::distanceSquared);
+                if (distanceSquared < farthest->distanceSquared) {
+                    *farthest = { candidate.get(), distanceSquared };
                 }
             }
-            
-            logger::info("{} performed knockback on {}", actor->GetName(), nearestEnemy->GetName());
+        }
+        
+        auto count = std::min<std::size_t>({ candidates.size(), settings->GetKnockbackMaxTargets(), N });
+        std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+            [](const Candidate& a, const Candidate& b) { return a.distanceSquared < b.distanceSquared; });
+        
+        for (std::size_t i = 0; i < count; ++i) {
+            targets.push_back(candidates[i].actor);
+        }
+    }
+    
+    // Staggers go out with the tick's idles, so a target several followers strike in one frame staggers once
+    void StaggerTarget(RE::Actor* source, RE::Actor* target, float magnitude) {
+        if (AnimUtil::IdleQueue::GetSingleton()->QueueStagger(target, source, magnitude)) {
+            logger::info("{} staggered {}", source->GetName(), target->GetName());
         }
     }
     
     RE::Actor* GetNearestEnemy(RE::Actor* actor) {
         if (!actor) return nullptr;
         
-        std::vector<RE::Actor*> combatTargets;
+        // The party allocator's pick comes first, so followers don't all strike the same enemy
+        if (auto assigned = CombatClasses::TargetAllocator::GetSingleton()->GetTarget(actor->GetFormID())) {
+            if (assigned->IsHostileToActor(actor)) {
+                return assigned.get();
+            }
+        }
+        
+        // At most the player's target and the actor's own target
+        FixedVector<RE::Actor*, 2> combatTargets;
         
         // Add player's combat target if relevant
         auto player = RE::PlayerCharacter::GetSingleton();
@@ -462,19 +837,8 @@ private:
         
         // Add actor's combat target
         auto targetPtr = actor->GetActorRuntimeData().currentCombatTarget.get();
-        if (targetPtr && !targetPtr->IsDead()) {
-            // Check if already in the list
-            bool found = false;
-            for (auto target : combatTargets) {
-                if (target == targetPtr.get()) {
-                    found = true;
-                    break;
-                }
-            }
-            
-            if (!found) {
-                combatTargets.push_back(targetPtr.get());
-            }
+        if (targetPtr && !targetPtr->IsDead() && !combatTargets.contains(targetPtr.get())) {
+            combatTargets.push_back(targetPtr.get());
         }
         
         // Find nearest from the targets
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include "thread_pool.h"
+
+// Binary capture of every event that reaches the sinks in hook.h, plus update ticks, so a heavy
+// session can be replayed later. Records are a type byte followed by LEB128 varints: the time since
+// the previous record in microseconds, three FormIDs and a flag.
+namespace EventLog {
+    inline constexpr std::uint32_t magic = 0x52455343;  // "CSER"
+    inline constexpr std::uint16_t version = 3;
+
+    enum class RecordType : std::uint8_t {
+        kTick,
+        kEquip,
+        kLoadGame,
+        kFormDelete,
+        kCellLoad,
+        kCombat,
+        kObjectLoaded,
+        kCellAttachDetach,
+        kHit,
+        kRegister,  // an actor joined (flag 1) or left (flag 0) the follower roster
+        kTypeCount
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(RecordType::kTypeCount)> recordTypeNames{
+        "Tick"sv, "Equip"sv, "LoadGame"sv, "FormDelete"sv, "CellLoad"sv, "Combat"sv, "ObjectLoaded"sv, "CellAttachDetach"sv, "Hit"sv, "Register"sv
+    };
+
+    struct Record {
+        RecordType type = RecordType::kTick;
+        // Microseconds since recording started
+        std::uint64_t timestampUs = 0;
+        RE::FormID first = 0;
+        RE::FormID second = 0;
+        // Only hits use it, for the weapon or spell
+        RE::FormID third = 0;
+        std::uint32_t flag = 0;
+    };
+
+    inline std::filesystem::path GetDefaultPath() {
+        auto logsFolder = SKSE::log::log_directory();
+        return logsFolder ? *logsFolder / "CS_CombatClasses_events.bin" : std::filesystem::path("CS_CombatClasses_events.bin");
+    }
+
+    inline void WriteVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    inline bool ReadVarint(std::span<const std::uint8_t>& in, std::uint64_t& value) {
+        value = 0;
+        for (std::uint32_t shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            auto byte = in.front();
+            in = in.subspan(1);
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Parses a whole log. Returns nullopt if the file is missing or not a log of this version;
+    // a truncated tail, e.g. from a crash, ends the list early.
+    inline std::optional<std::vector<Record>> ReadFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+        std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        std::span<const std::uint8_t> in(bytes);
+        if (in.size() < 6) {
+            return std::nullopt;
+        }
+        std::uint32_t fileMagic = 0;
+        std::uint16_t fileVersion = 0;
+        std::memcpy(&fileMagic, in.data(), 4);
+        std::memcpy(&fileVersion, in.data() + 4, 2);
+        if (fileMagic != magic || fileVersion != version) {
+            return std::nullopt;
+        }
+        in = in.subspan(6);
+
+        std::vector<Record> records;
+        std::uint64_t timestamp = 0;
+        while (!in.empty()) {
+            Record record;
+            auto type = in.front();
+            in = in.subspan(1);
+            if (type >= static_cast<std::uint8_t>(RecordType::kTypeCount)) {
+                break;
+            }
+            record.type = static_cast<RecordType>(type);
+
+            std::uint64_t delta = 0, first = 0, second = 0, third = 0, flag = 0;
+            if (!ReadVarint(in, delta) || !ReadVarint(in, first) || !ReadVarint(in, second) || !ReadVarint(in, third) || !ReadVarint(in, flag)) {
+                break;
+            }
+            timestamp += delta;
+            record.timestampUs = timestamp;
+            record.first = static_cast<RE::FormID>(first);
+            record.second = static_cast<RE::FormID>(second);
+            record.third = static_cast<RE::FormID>(third);
+            record.flag = static_cast<std::uint32_t>(flag);
+            records.push_back(record);
+        }
+        return records;
+    }
+
+    class Recorder {
+    private:
+        static inline Recorder* instance = nullptr;
+
+        // Buffered bytes are handed to a worker once they pass this size
+        static constexpr std::size_t flushThreshold = 64 * 1024;
+
+        bool recording = false;
+        std::chrono::steady_clock::time_point started;
+        std::uint64_t lastTimestampUs = 0;
+        std::uint64_t recordCount = 0;
+        std::vector<std::uint8_t> buffer;
+
+        // Chunks waiting to be written. Workers drain them in order under fileLock, so chunks reach
+        // the file in the order they were produced even if flush jobs run out of order.
+        std::mutex queueLock;
+        std::deque<std::vector<std::uint8_t>> queued;
+        std::mutex fileLock;
+        std::ofstream file;
+        // Which Start opened the file, so a late close from an earlier Stop leaves a new recording alone
+        std::uint32_t session = 0;
+
+        Recorder() = default;
+
+    public:
+        static Recorder* GetSingleton() {
+            if (!instance) {
+                instance = new Recorder();
+            }
+            return instance;
+        }
+
+        bool IsRecording() const { return recording; }
+
+        bool Start(const std::filesystem::path& path = GetDefaultPath()) {
+            if (recording) {
+                return false;
+            }
+
+            {
+                std::scoped_lock guard(fileLock);
+                DrainQueued();
+                if (file.is_open()) {
+                    file.close();
+                }
+                ++session;
+                file.open(path, std::ios::binary | std::ios::trunc);
+                if (!file) {
+                    logger::error("Could not open {} for event recording", path.string());
+                    return false;
+                }
+            }
+
+            buffer.clear();
+            buffer.reserve(flushThreshold);
+            buffer.resize(6);
+            std::memcpy(buffer.data(), &magic, 4);
+            std::memcpy(buffer.data() + 4, &version, 2);
+
+            started = std::chrono::steady_clock::now();
+            lastTimestampUs = 0;
+            recordCount = 0;
+            recording = true;
+
+            logger::info("Recording events to {}", path.string());
+            return true;
+        }
+
+        void Stop() {
+            if (!recording) {
+                return;
+            }
+            recording = false;
+
+            // Closing happens after every queued chunk, on the same ordered path
+            Flush();
+            ThreadPool::GetSingleton()->Submit([this, stopped = session]() {
+                std::scoped_lock guard(fileLock);
+                DrainQueued();
+                if (session == stopped) {
+                    file.close();
+                }
+            });
+
+            logger::info("Stopped recording after {} events", recordCount);
+        }
+
+        // Game thread only, like the sinks that call it
+        void Record(RecordType type, RE::FormID first = 0, RE::FormID second = 0, std::uint32_t flag = 0, RE::FormID third = 0) {
+            if (!recording) {
+                return;
+            }
+
+            auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
+            buffer.push_back(static_cast<std::uint8_t>(type));
+            WriteVarint(buffer, now - lastTimestampUs);
+            WriteVarint(buffer, first);
+            WriteVarint(buffer, second);
+            WriteVarint(buffer, third);
+            WriteVarint(buffer, flag);
+            lastTimestampUs = now;
+            ++recordCount;
+
+            if (buffer.size() >= flushThreshold) {
+                Flush();
+            }
+        }
+
+    private:
+        void Flush() {
+            if (buffer.empty()) {
+                return;
+            }
+
+            {
+                std::scoped_lock guard(queueLock);
+                queued.push_back(std::move(buffer));
+            }
+            buffer = {};
+            buffer.reserve(flushThreshold);
+
+            ThreadPool::GetSingleton()->Submit([this]() {
+                std::scoped_lock guard(fileLock);
+                DrainQueued();
+            });
+        }
+
+        // Caller holds fileLock
+        void DrainQueued() {
+            std::deque<std::vector<std::uint8_t>> chunks;
+            {
+                std::scoped_lock guard(queueLock);
+                chunks.swap(queued);
+            }
+            for (const auto& chunk : chunks) {
+                if (file) {
+                    file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+                }
+            }
+            if (file) {
+                file.flush();
+            }
+        }
+    };
+}
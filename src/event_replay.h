@@ -0,0 +1,163 @@
+#pragma once
+
+#include "actor_roster.h"
+#include "event_log.h"
+
+// Replays a recorded event log through the same ActorRoster the combat update keeps its followers in:
+// registrations, loads, unloads, fights and the tick gating all go through the code the game runs.
+// Nothing is looked up or changed in the game, so a log can be replayed in any save, on a worker, or on
+// a desktop machine with no game at all. Events run back to back, so the timings measure the filtering
+// and bookkeeping every event goes through before the plugin makes any game call.
+//
+// The replay also checks the log against the roster: every recorded tick must be one the roster lets
+// through, and the fighter count the tick recorded must match the roster's.
+namespace EventLog {
+    struct ReplayStats {
+        std::uint64_t count = 0;
+        std::chrono::nanoseconds total{ 0 };
+        std::chrono::nanoseconds max{ 0 };
+        std::uint64_t allocations = 0;
+    };
+
+    struct ReplayResult {
+        std::array<ReplayStats, static_cast<std::size_t>(RecordType::kTypeCount)> stats{};
+        std::chrono::nanoseconds elapsed{ 0 };
+        std::uint64_t recordedUs = 0;
+        // Whether the allocation counts were measured
+        bool countedAllocations = false;
+
+        // Ticks recorded while the roster's gating would have stopped the update
+        std::uint64_t ticksOutsideCombat = 0;
+        // Ticks whose recorded fighter count differs from the roster's
+        std::uint64_t tickMismatches = 0;
+        std::uint64_t partyHits = 0;    // hits by a registered actor
+        std::uint64_t partyWounds = 0;  // hits taken by a registered actor
+        std::size_t maxFighters = 0;
+    };
+
+    class ReplayModel {
+    private:
+        // Replay has no actors to hold on to
+        struct NoHandle {};
+
+        ActorRoster<NoHandle> roster;
+
+    public:
+        const ActorRoster<NoHandle>& GetRoster() const { return roster; }
+
+        // Applies one record the way the sinks in hook.h apply it to PeriodicUpdateTask
+        void Apply(const Record& record, ReplayResult& result) {
+            switch (record.type) {
+            case RecordType::kRegister:
+                if (record.flag) {
+                    roster.Register(record.first);
+                } else if (roster.Unregister(record.first)) {
+                    roster.Unload(record.first);
+                }
+                break;
+            case RecordType::kTick:
+                // The update asks the roster before every tick, so a recorded tick it would refuse did not come from this gating
+                if (!roster.IsTicking() || !roster.ContinueTicking()) {
+                    ++result.ticksOutsideCombat;
+                }
+                if (record.first != roster.GetFighting().size()) {
+                    ++result.tickMismatches;
+                }
+                break;
+            case RecordType::kLoadGame:
+                // Registrations outlive a load; who is loaded and fighting does not
+                roster.Reset();
+                break;
+            case RecordType::kObjectLoaded:
+                if (record.flag) {
+                    roster.Load(record.first, {});
+                } else {
+                    roster.Unload(record.first);
+                }
+                break;
+            case RecordType::kCellAttachDetach:
+                if (!record.flag) {
+                    roster.Unload(record.first);
+                }
+                break;
+            case RecordType::kFormDelete:
+                if (roster.Unregister(record.first)) {
+                    roster.Unload(record.first);
+                }
+                break;
+            case RecordType::kCombat:
+                // Searching still counts as combat; only a return to kNone ends it
+                if (record.flag != 0) {
+                    if (roster.EnterCombat(record.first, {})) {
+                        roster.StartTicking();
+                        result.maxFighters = std::max(result.maxFighters, roster.GetFighting().size());
+                    }
+                } else {
+                    roster.LeaveCombat(record.first);
+                }
+                break;
+            case RecordType::kHit:
+                result.partyHits += roster.IsRegistered(record.second);
+                result.partyWounds += roster.IsRegistered(record.first);
+                break;
+            default:
+                break;
+            }
+        }
+    };
+
+    // countAllocations, when given, reads a process-wide allocation count; the host tools pass the one from
+    // tests/alloc_counter.h. Without it the allocation columns stay empty.
+    inline ReplayResult Replay(std::span<const Record> records, std::uint64_t (*countAllocations)() = nullptr) {
+        ReplayModel model;
+        ReplayResult result;
+        result.recordedUs = records.empty() ? 0 : records.back().timestampUs;
+        result.countedAllocations = countAllocations != nullptr;
+
+        auto started = std::chrono::steady_clock::now();
+        for (const auto& record : records) {
+            auto allocationsBefore = countAllocations ? countAllocations() : 0;
+            auto before = std::chrono::steady_clock::now();
+            model.Apply(record, result);
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before);
+
+            auto& typeStats = result.stats[static_cast<std::size_t>(record.type)];
+            ++typeStats.count;
+            typeStats.total += elapsed;
+            typeStats.max = std::max(typeStats.max, elapsed);
+            if (countAllocations) {
+                typeStats.allocations += countAllocations() - allocationsBefore;
+            }
+        }
+        result.elapsed = std::chrono::steady_clock::now() - started;
+        return result;
+    }
+
+    // Reads and replays a log, then writes the summary to the plugin log. Any thread.
+    inline bool ReplayFile(const std::filesystem::path& path = GetDefaultPath()) {
+        auto records = ReadFile(path);
+        if (!records) {
+            logger::error("Could not read event log {}", path.string());
+            return false;
+        }
+
+        auto result = Replay(*records);
+        logger::info("Replayed {} events from {} in {}us (recorded over {}us)", records->size(), path.string(),
+            std::chrono::duration_cast<std::chrono::microseconds>(result.elapsed).count(), result.recordedUs);
+
+        for (std::size_t i = 0; i < result.stats.size(); ++i) {
+            const auto& typeStats = result.stats[i];
+            if (typeStats.count == 0) {
+                continue;
+            }
+            logger::info("  {:<16} {:>8} events, avg {:>6}ns, max {:>8}ns", recordTypeNames[i], typeStats.count,
+                typeStats.total.count() / static_cast<std::int64_t>(typeStats.count), typeStats.max.count());
+        }
+        logger::info("  party hits {}, party wounds {}, most fighting at once {}", result.partyHits, result.partyWounds, result.maxFighters);
+        if (result.ticksOutsideCombat || result.tickMismatches) {
+            logger::warn("  {} ticks ran with nobody fighting, {} disagreed with the replayed fighter count",
+                result.ticksOutsideCombat, result.tickMismatches);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <bit>
+
+// Fixed-capacity storage for per-tick paths that must not touch the heap
+
+// Inline vector with a hard capacity. push_back reports whether the element fit.
+template <class T, std::size_t N>
+class FixedVector {
+private:
+    std::array<T, N> items{};
+    std::size_t count = 0;
+
+public:
+    bool push_back(const T& item) {
+        if (count == N) {
+            return false;
+        }
+        items[count++] = item;
+        return true;
+    }
+
+    void clear() { count = 0; }
+
+    // Drops the first n elements and moves the rest up, in order
+    void erase_front(std::size_t n) {
+        n = std::min(n, count);
+        std::move(items.begin() + n, items.begin() + count, items.begin());
+        count -= n;
+    }
+
+    bool contains(const T& item) const { return std::find(begin(), end(), item) != end(); }
+
+    T& operator[](std::size_t index) { return items[index]; }
+    const T& operator[](std::size_t index) const { return items[index]; }
+
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + count; }
+    const T* begin() const { return items.data(); }
+    const T* end() const { return items.data() + count; }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == N; }
+    static constexpr std::size_t capacity() { return N; }
+};
+
+// Open addressed hash map with a hard capacity, for small tables that are probed and churned every tick.
+// Linear probing with backward-shift erase, so there are no tombstones and lookups stay short however
+// many keys come and go. A quarter of the slots always stays free.
+template <class Key, class Value, std::size_t N>
+class FixedMap {
+    static_assert(std::has_single_bit(N) && N >= 4);
+
+private:
+    static constexpr std::size_t mask = N - 1;
+    static constexpr std::uint32_t shift = 64 - std::countr_zero(N);
+
+    struct Slot {
+        Key key{};
+        Value value{};
+        bool used = false;
+    };
+
+    std::array<Slot, N> slots{};
+    std::size_t count = 0;
+
+    static std::size_t Home(Key key) { return static_cast<std::size_t>((static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> shift); }
+
+    // The key's slot, or the free slot where it would go
+    std::size_t Locate(Key key) const {
+        auto index = Home(key);
+        while (slots[index].used && slots[index].key != key) {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    // Pulls later entries of the probe run back into the hole so every key stays reachable from its home
+    void EraseAt(std::size_t hole) {
+        --count;
+        for (auto index = (hole + 1) & mask; slots[index].used; index = (index + 1) & mask) {
+            auto home = Home(slots[index].key);
+            if (((index - home) & mask) >= ((index - hole) & mask)) {
+                slots[hole] = std::move(slots[index]);
+                hole = index;
+            }
+        }
+        slots[hole].used = false;
+    }
+
+public:
+    Value* find(Key key) {
+        auto& slot = slots[Locate(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    const Value* find(Key key) const {
+        const auto& slot = slots[Locate(key)];
+        return slot.used ? &slot.value : nullptr;
+    }
+
+    bool contains(Key key) const { return find(key) != nullptr; }
+
+    // The key's value, inserted value-initialized if it is new. Null when the key is new and the map is full.
+    Value* try_emplace(Key key) {
+        auto index = Locate(key);
+        if (!slots[index].used) {
+            if (count == capacity()) {
+                return nullptr;
+            }
+            slots[index] = { key, Value{}, true };
+            ++count;
+        }
+        return &slots[index].value;
+    }
+
+    bool erase(Key key) {
+        auto index = Locate(key);
+        if (!slots[index].used) {
+            return false;
+        }
+        EraseAt(index);
+        return true;
+    }
+
+    // Erases every entry for which predicate(key, value) holds. Returns how many went.
+    template <class Predicate>
+    std::size_t erase_if(Predicate&& predicate) {
+        std::size_t erased = 0;
+        for (std::size_t index = 0; index < N;) {
+            // An entry shifted into the hole is checked before moving on
+            if (slots[index].used && predicate(std::as_const(slots[index].key), std::as_const(slots[index].value))) {
+                EraseAt(index);
+                ++erased;
+            } else {
+                ++index;
+            }
+        }
+        return erased;
+    }
+
+    template <class Visit>
+    void for_each(Visit&& visit) const {
+        for (const auto& slot : slots) {
+            if (slot.used) {
+                visit(slot.key, slot.value);
+            }
+        }
+    }
+
+    void clear() {
+        if (count == 0) {
+            return;
+        }
+        for (auto& slot : slots) {
+            slot.used = false;
+        }
+        count = 0;
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == capacity(); }
+    static constexpr std::size_t capacity() { return N - N / 4; }
+};
+
+// Reusable text buffer for notifications. Output longer than N - 1 characters is truncated.
+template <std::size_t N>
+class FormatBuffer {
+private:
+    std::array<char, N> data{};
+
+public:
+    template <class... Args>
+    const char* Format(fmt::format_string<Args...> format, Args&&... args) {
+        auto result = fmt::format_to_n(data.data(), N - 1, format, std::forward<Args>(args)...);
+        *result.out = '\0';
+        return data.data();
+    }
+};
+
+// Bitset over hashed FormIDs. A clear bit proves a form is not tracked with one multiply, shift
+// and bit test; a set bit still needs an exact lookup.
+template <std::size_t Bits>
+class FormIDFilter {
+    static_assert(std::has_single_bit(Bits) && Bits >= 64);
+
+private:
+    static constexpr std::uint32_t shift = 32 - std::countr_zero(Bits);
+
+    std::array<std::uint64_t, Bits / 64> words{};
+
+    static std::uint32_t Slot(RE::FormID formID) { return (formID * 0x9E3779B1u) >> shift; }
+
+public:
+    void Insert(RE::FormID formID) {
+        auto slot = Slot(formID);
+        words[slot >> 6] |= 1ull << (slot & 63);
+    }
+
+    bool MayContain(RE::FormID formID) const {
+        auto slot = Slot(formID);
+        return (words[slot >> 6] >> (slot & 63)) & 1;
+    }
+
+    void Clear() { words.fill(0); }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+
+// Engine-facing strings, interned once. Building a BSFixedString inserts into the engine's global
+// string table under its lock, so hot paths refer to these by ID instead of constructing one per call.
+namespace FixedStrings {
+    enum class ID : std::uint8_t {
+        // Papyrus dispatch
+        kObjectReference,
+        kPushActorAway,
+
+        // Animation graph
+        kStaggerDirection,
+        kStaggerMagnitude,
+        kStaggerStart,
+        kBowRelease,
+
+        // Skeleton bones
+        kNPCRoot,
+        kNPCHead,
+        kNPCRightHand,
+        kNPCLeftHand,
+        kWeapon,
+        kShield,
+        kQuiver,
+
+        kCount
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(ID::kCount)> names{
+        "ObjectReference"sv,
+        "PushActorAway"sv,
+        "staggerDirection"sv,
+        "StaggerMagnitude"sv,
+        "staggerStart"sv,
+        "BowRelease"sv,
+        "NPC Root [Root]"sv,
+        "NPC Head [Head]"sv,
+        "NPC R Hand [RHnd]"sv,
+        "NPC L Hand [LHnd]"sv,
+        "WEAPON"sv,
+        "SHIELD"sv,
+        "QUIVER"sv
+    };
+
+    class Registry {
+    private:
+        static inline Registry* instance = nullptr;
+
+        std::array<RE::BSFixedString, static_cast<std::size_t>(ID::kCount)> strings;
+
+        Registry() {
+            for (std::size_t i = 0; i < strings.size(); ++i) {
+                strings[i] = names[i];
+            }
+        }
+
+    public:
+        // First called from OnDataLoaded, so every string is interned at startup
+        static Registry* GetSingleton() {
+            if (!instance) {
+                instance = new Registry();
+            }
+            return instance;
+        }
+
+        const RE::BSFixedString& Get(ID id) const { return strings[static_cast<std::size_t>(id)]; }
+    };
+
+    inline const RE::BSFixedString& Get(ID id) {
+        return Registry::GetSingleton()->Get(id);
+    }
+}
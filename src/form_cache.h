@@ -0,0 +1,113 @@
+#pragma once
+
+#include "settings.h"
+
+// Memoized classification of base forms. Everything here is derived from the config plus immutable
+// record data, so an entry is computed the first time a base form is seen and then reused for every
+// reference of it until settings are applied again.
+namespace CombatClasses {
+    // Which follower bonus a weapon grants while drawn
+    enum class BonusProfile : std::uint8_t {
+        kNone,
+        kBow,
+        kSpecialBow,
+        kKnockback
+    };
+
+    struct WeaponInfo {
+        RE::WEAPON_TYPE type = RE::WEAPON_TYPE::kHandToHandMelee;
+        BonusProfile bonus = BonusProfile::kNone;
+        ProfileID profile = kNoProfile;
+
+        bool IsBow() const { return bonus == BonusProfile::kBow || bonus == BonusProfile::kSpecialBow; }
+        bool IsSpecialBow() const { return bonus == BonusProfile::kSpecialBow; }
+        bool IsSpecialSword() const { return bonus == BonusProfile::kKnockback; }
+    };
+
+    class FormCache {
+    private:
+        static inline FormCache* instance = nullptr;
+
+        std::unordered_map<RE::FormID, WeaponInfo> weapons;
+
+        // Rule bits of NPC bases, keyed by the template a leveled actor was generated from
+        std::unordered_map<RE::FormID, RuleBits> npcs;
+
+        // Settings generation the entries were computed against
+        std::uint32_t generation = 0;
+
+        FormCache() = default;
+
+    public:
+        static FormCache* GetSingleton() {
+            if (!instance) {
+                instance = new FormCache();
+            }
+            return instance;
+        }
+
+        const WeaponInfo& GetWeapon(const RE::TESObjectWEAP* weapon) {
+            Validate();
+
+            auto [it, inserted] = weapons.try_emplace(weapon->GetFormID());
+            if (inserted) {
+                it->second = ClassifyWeapon(weapon);
+            }
+            return it->second;
+        }
+
+        // Class from the first matching rule. Only the reference-specific predicates are evaluated per call.
+        ClassID GetRuleClass(RE::Actor* actor) {
+            Validate();
+
+            const auto& rules = Settings::GetSingleton()->GetRuleTable();
+            if (rules.empty()) {
+                return kNoClass;
+            }
+
+            auto npc = actor->GetActorBase();
+            if (!npc) {
+                return kNoClass;
+            }
+
+            // Leveled actors get a temporary base per reference; the template it was built from is stable
+            auto key = actor->GetTemplateActorBase();
+            auto keyID = key ? key->GetFormID() : npc->GetFormID();
+
+            auto [it, inserted] = npcs.try_emplace(keyID);
+            if (inserted) {
+                it->second = rules.EvaluateBase(npc);
+            }
+            return rules.Match(actor, it->second);
+        }
+
+        void Clear() {
+            weapons.clear();
+            npcs.clear();
+        }
+
+    private:
+        void Validate() {
+            auto current = Settings::GetSingleton()->GetAppliedGeneration();
+            if (generation != current) {
+                Clear();
+                generation = current;
+            }
+        }
+
+        static WeaponInfo ClassifyWeapon(const RE::TESObjectWEAP* weapon) {
+            auto settings = Settings::GetSingleton();
+            auto weaponID = weapon->GetFormID();
+
+            WeaponInfo info;
+            info.type = weapon->GetWeaponType();
+            if (info.type == RE::WEAPON_TYPE::kBow) {
+                info.bonus = settings->IsSpecialBow(weaponID) ? BonusProfile::kSpecialBow : BonusProfile::kBow;
+            } else if (settings->IsSpecialSword(weaponID)) {
+                info.bonus = BonusProfile::kKnockback;
+            }
+            info.profile = settings->GetWeaponProfiles().FindID(weaponID);
+            return info;
+        }
+    };
+}
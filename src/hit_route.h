@@ -0,0 +1,58 @@
+#pragma once
+
+// What HitEventHandler does with a hit, over an adapter for the event so the same checks run on the
+// host. Every hit in the world comes through here, nearly all of them between NPCs with ordinary weapons,
+// so the checks that turn those away come first and the attacker is only resolved when something uses it.
+//
+// The adapter provides:
+//   MayBeStrike()                          the source passes the strike weapon filter
+//   VictimID(), AttackerID()               the form IDs of the target and the cause
+//   IsPartyVictim(victimID)                the target is a registered follower or the player
+//   IsRegistered(formID)                   the actor is a registered follower
+//   IsRecording(), IsCounting()            the event log records, telemetry counts
+//   IsHeavy(), IsBlocked()                 power or sneak attack, blocked
+//   Record(victimID, attackerID)           writes the hit to the event log
+//   Count(attackerID)                      adds the hit to the follower's telemetry
+//   Strike()                               hands the hit to the strike weapon
+//   AddThreat(victimID, attackerID, amount)
+template <class Hit>
+void RouteHit(Hit& hit) {
+    bool strikeWeapon = hit.MayBeStrike();
+    auto victimID = hit.VictimID();
+    bool partyVictim = hit.IsPartyVictim(victimID);
+    bool recording = hit.IsRecording();
+    bool counting = hit.IsCounting();
+    if (!strikeWeapon && !partyVictim && !recording && !counting) {
+        return;
+    }
+
+    auto attackerID = hit.AttackerID();
+    if (recording) {
+        hit.Record(victimID, attackerID);
+    }
+
+    // Strike weapons and the hit counter act on the follower's own hits
+    if ((strikeWeapon || counting) && hit.IsRegistered(attackerID)) {
+        if (counting) {
+            hit.Count(attackerID);
+        }
+        if (strikeWeapon) {
+            hit.Strike();
+        }
+    }
+
+    // Only the party's own wounds feed threat
+    if (!partyVictim || victimID == attackerID) {
+        return;
+    }
+
+    // Heavier blows count for more, blocked ones for less
+    auto amount = 1.0f;
+    if (hit.IsHeavy()) {
+        amount *= 2.0f;
+    }
+    if (hit.IsBlocked()) {
+        amount *= 0.5f;
+    }
+    hit.AddThreat(victimID, attackerID, amount);
+}
@@ -1,7 +1,14 @@
 #pragma once
 
-#include <unordered_set>
+#include "actor_roster.h"
 #include "combat_classes.h"
+#include "event_log.h"
+#include "fixed_containers.h"
+#include "hit_route.h"
+#include "idle_queue.h"
+#include "target_allocator.h"
+#include "telemetry.h"
+#include "threat_map.h"
 #include <chrono>
 
 using namespace std::chrono_literals;
@@ -37,6 +44,8 @@ public:
             return RE::BSEventNotifyControl::kContinue;
         }
         
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kEquip, actor->GetFormID(), object->GetFormID(), event->equipped);
+        
         if (event->equipped) {
             // Equip event
             CombatClassesManager::GetSingleton()->OnActorEquip(actor, object);
@@ -57,39 +66,40 @@ public:
     }
 };
 
-class LoadGameEventHandler : public RE::BSTEventSink<RE::TESLoadGameEvent> {
+// Counts bow releases of the followers it is attached to. Graph events can arrive off the game
+// thread, so this only compares an interned tag and bumps an atomic counter.
+class BowReleaseEventHandler : public RE::BSTEventSink<RE::BSAnimationGraphEvent> {
 private:
-    static inline LoadGameEventHandler* instance = nullptr;
+    static inline BowReleaseEventHandler* instance = nullptr;
     
-    LoadGameEventHandler() = default;
+    BowReleaseEventHandler() = default;
 
 public:
-    static LoadGameEventHandler* GetSingleton() {
+    static BowReleaseEventHandler* GetSingleton() {
         if (!instance) {
-            instance = new LoadGameEventHandler();
+            instance = new BowReleaseEventHandler();
         }
         return instance;
     }
     
-    RE::BSEventNotifyControl ProcessEvent(const RE::TESLoadGameEvent*, RE::BSTEventSource<RE::TESLoadGameEvent>*) override {
-        logger::info("Game loaded, initializing Combat Classes Manager");
+    RE::BSEventNotifyControl ProcessEvent(const RE::BSAnimationGraphEvent* event, RE::BSTEventSource<RE::BSAnimationGraphEvent>*) override {
+        if (!event || !event->holder || event->tag != FixedStrings::Get(FixedStrings::ID::kBowRelease)) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
         
-        // Load settings
-        Settings::GetSingleton()->LoadSettings();
+        auto actor = event->holder->As<RE::Actor>();
+        if (!actor) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
         
-        // Initialize manager
-        CombatClassesManager::GetSingleton()->Initialize();
+        auto weapon = actor->GetEquippedObject(false);
+        Telemetry::Add(Telemetry::Counter::kArrowsFired, actor->GetFormID(), weapon ? weapon->GetFormID() : 0);
         
         return RE::BSEventNotifyControl::kContinue;
     }
     
-    void Register() {
-        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
-        if (eventHolder) {
-            eventHolder->AddEventSink<RE::TESLoadGameEvent>(this);
-            logger::info("Registered load game event handler");
-        }
-    }
+    void Attach(RE::Actor* actor) { actor->AddAnimationGraphEventSink(this); }
+    void Detach(RE::Actor* actor) { actor->RemoveAnimationGraphEventSink(this); }
 };
 
 // SKSE Task that is called periodically
@@ -99,8 +109,19 @@ private:
     
     PeriodicUpdateTask() = default;
     
-    // Handler for registered actors
-    std::unordered_set<RE::FormID> registeredActors;
+    // Registered, loaded and fighting actors. Handles are taken on load and dropped on unload, delete or
+    // cell detach, so ticks never go through the global form map. Event replay runs the same bookkeeping.
+    ActorRoster<RE::ActorHandle> roster;
+    
+    // Queued every frame while in combat. SKSE calls Dispose after Run, which would normally free
+    // the task; this one lives as long as the plugin so queueing it never allocates.
+    class UpdateDelegate : public SKSE::TaskDelegate {
+    public:
+        void Run() override { PeriodicUpdateTask::GetSingleton()->ProcessAll(); }
+        void Dispose() override {}
+    };
+    
+    UpdateDelegate updateDelegate;
 
 public:
     static PeriodicUpdateTask* GetSingleton() {
@@ -110,6 +131,7 @@ public:
         return instance;
     }
 
+    // Registers the configured followers. Called whenever settings finish loading.
     static void Register() {
         auto task = GetSingleton();
         
@@ -117,39 +139,329 @@ public:
         for (const auto& [name, formID] : followers) {
             if (Settings::GetSingleton()->IsFollowerEnabled(formID)) {
                 task->RegisterActor(formID);
+                
+                // Followers that are already in the world won't get another load event
+                auto actor = RE::TESForm::LookupByID<RE::Actor>(formID);
+                if (actor && actor->Is3DLoaded()) {
+                    task->OnActorLoaded(actor);
+                }
             }
         }
         
-        // Schedule the first update
-        SKSE::GetTaskInterface()->AddTask([task]() {
-            task->ProcessAll();
-        });
-        
+        // Updates are scheduled when the first follower enters combat
         logger::info("Registered periodic update task");
     }
     
     void RegisterActor(RE::FormID formID) {
-        registeredActors.insert(formID);
+        if (roster.Register(formID)) {
+            EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kRegister, formID, 0, 1);
+        }
     }
     
     void UnregisterActor(RE::FormID formID) {
-        registeredActors.erase(formID);
+        if (!roster.Unregister(formID)) {
+            return;
+        }
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kRegister, formID, 0, 0);
+        OnActorUnloaded(formID);
+    }
+    
+    bool IsRegistered(RE::FormID formID) const { return roster.IsRegistered(formID); }
+    
+    void OnActorLoaded(RE::Actor* actor) {
+        auto formID = actor->GetFormID();
+        if (!roster.Load(formID, actor->GetHandle())) {
+            return;
+        }
+        BowReleaseEventHandler::GetSingleton()->Attach(actor);
+        
+        // Loaded straight into a fight, e.g. from a save. No combat event comes for that, so the log gets one here.
+        if (actor->IsInCombat()) {
+            EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kCombat, formID, 0,
+                static_cast<std::uint32_t>(RE::ACTOR_COMBAT_STATE::kCombat));
+            OnCombatStateChanged(actor, true);
+        }
+    }
+    
+    void OnActorUnloaded(RE::FormID formID) {
+        // The graph may already be gone with the 3D, in which case so is the sink
+        if (auto handle = roster.Unload(formID)) {
+            if (auto actor = handle->get()) {
+                BowReleaseEventHandler::GetSingleton()->Detach(actor.get());
+            }
+        }
+    }
+    
+    // Cached pointer for a loaded registered actor, or null
+    RE::NiPointer<RE::Actor> GetLoadedActor(RE::FormID formID) {
+        auto handle = roster.FindLoaded(formID);
+        return handle ? handle->get() : nullptr;
+    }
+    
+    void OnCombatStateChanged(RE::Actor* actor, bool inCombat) {
+        auto formID = actor->GetFormID();
+        if (inCombat) {
+            if (roster.EnterCombat(formID, actor->GetHandle())) {
+                CombatClassesManager::GetSingleton()->OnCombatStart(actor);
+                Start();
+            }
+        } else if (roster.LeaveCombat(formID)) {
+            CombatClassesManager::GetSingleton()->OnCombatEnd(actor);
+        }
+    }
+    
+    // Writes the current roster and who is loaded and fighting to the event log, so a recording started
+    // mid-session replays from the same state
+    void RecordState() const {
+        auto recorder = EventLog::Recorder::GetSingleton();
+        for (auto formID : roster.GetRegistered()) {
+            recorder->Record(EventLog::RecordType::kRegister, formID, 0, 1);
+        }
+        for (const auto& tracked : roster.GetLoaded()) {
+            recorder->Record(EventLog::RecordType::kObjectLoaded, tracked.formID, 0, 1);
+        }
+        for (const auto& tracked : roster.GetFighting()) {
+            recorder->Record(EventLog::RecordType::kCombat, tracked.formID, 0, static_cast<std::uint32_t>(RE::ACTOR_COMBAT_STATE::kCombat));
+        }
+    }
+    
+    // Drops the followers scripts registered through the Papyrus API, along with their registration here unless
+    // the config lists them too. Before a load or new game, so the next session's scripts start from nothing.
+    void ForgetRuntimeFollowers() {
+        auto settings = Settings::GetSingleton();
+        for (auto formID : settings->TakeRuntimeFollowers()) {
+            if (!settings->IsFollower(formID)) {
+                UnregisterActor(formID);
+            }
+        }
+    }
+    
+    // Forgets every loaded and fighting actor along with the per-fight caches, the manager's actor state and
+    // every pending timer. Registrations stay; the followers of the new session report in again through
+    // Register and their load events, and start from the values in the save.
+    void Reset() {
+        roster.Reset();
+        ClearFightState();
+        CombatClassesManager::GetSingleton()->Reset();
+        Timers::Scheduler::GetSingleton()->Clear();
     }
     
     void ProcessAll() {
-        for (const RE::FormID& formID : registeredActors) {
-            auto actor = RE::TESForm::LookupByID<RE::Actor>(formID);
+        // Nobody is fighting, so stop ticking until the next combat starts
+        if (!roster.ContinueTicking()) {
+            ClearFightState();
+            return;
+        }
+        
+        Tick();
+        
+        // Schedule the next update
+        auto taskInterface = SKSE::GetTaskInterface();
+        if (taskInterface) {
+            taskInterface->AddTask(&updateDelegate);
+        } else {
+            roster.StopTicking();
+        }
+    }
+    
+    // One update while anyone fights: due timers fire, then the work they queued goes out
+    void Tick() {
+        const auto& fighting = roster.GetFighting();
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kTick, static_cast<RE::FormID>(fighting.size()));
+        
+        // Spread the party over the enemies before anything picks a target this tick
+        FixedVector<RE::Actor*, CombatClasses::TargetAllocator::maxFollowers> fighters;
+        for (const auto& tracked : fighting) {
+            auto actor = tracked.handle.get();
             if (actor && actor->Is3DLoaded()) {
-                CombatClassesManager::GetSingleton()->Update(actor);
+                fighters.push_back(actor.get());
             }
         }
+        CombatClasses::TargetAllocator::GetSingleton()->Update(std::span(fighters.begin(), fighters.end()));
+        
+        // Line of sight checks the allocation asked for, answered for the next tick
+        CombatClasses::LineOfSightCache::GetSingleton()->Resolve();
+        
+        // Strike cooldowns and other per-actor timers fire from here, so idle actors cost nothing
+        Timers::Scheduler::GetSingleton()->Advance();
+        
+        // Knockbacks from every follower go out together, under the per-frame cap
+        CombatClassesManager::GetSingleton()->FlushPushes();
+        
+        // Idles requested during the updates, at most one per actor
+        AnimUtil::IdleQueue::GetSingleton()->Flush();
+    }
+    
+private:
+    static void ClearFightState() {
+        CombatClassesManager::GetSingleton()->ClearPendingPushes();
+        AnimUtil::IdleQueue::GetSingleton()->Clear();
+        CombatClasses::TargetAllocator::GetSingleton()->Clear();
+        CombatClasses::LineOfSightCache::GetSingleton()->Clear();
+        CombatClasses::ThreatMap::GetSingleton()->Clear();
+    }
+    
+    void Start() {
+        if (!roster.StartTicking()) {
+            return;
+        }
         
-        // Schedule the next update
         auto taskInterface = SKSE::GetTaskInterface();
         if (taskInterface) {
-            taskInterface->AddTask([this]() {
-                this->ProcessAll();
-            });
+            taskInterface->AddTask(&updateDelegate);
+        } else {
+            roster.StopTicking();
+        }
+    }
+};
+
+class LoadGameEventHandler : public RE::BSTEventSink<RE::TESLoadGameEvent> {
+private:
+    static inline LoadGameEventHandler* instance = nullptr;
+    
+    LoadGameEventHandler() = default;
+
+public:
+    static LoadGameEventHandler* GetSingleton() {
+        if (!instance) {
+            instance = new LoadGameEventHandler();
+        }
+        return instance;
+    }
+    
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESLoadGameEvent*, RE::BSTEventSource<RE::TESLoadGameEvent>*) override {
+        logger::info("Game loaded, initializing Combat Classes Manager");
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kLoadGame);
+        
+        // Handles and fights from the previous session mean nothing in this one
+        PeriodicUpdateTask::GetSingleton()->Reset();
+        
+        // Reload settings off-thread, then initialize the manager
+        Settings::GetSingleton()->LoadSettingsAsync([]() {
+            CombatClassesManager::GetSingleton()->Initialize();
+            PeriodicUpdateTask::Register();
+        });
+        
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    
+    void Register() {
+        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder) {
+            eventHolder->AddEventSink<RE::TESLoadGameEvent>(this);
+            logger::info("Registered load game event handler");
+        }
+    }
+};
+
+class CombatEventHandler : public RE::BSTEventSink<RE::TESCombatEvent> {
+private:
+    static inline CombatEventHandler* instance = nullptr;
+    
+    CombatEventHandler() = default;
+
+public:
+    static CombatEventHandler* GetSingleton() {
+        if (!instance) {
+            instance = new CombatEventHandler();
+        }
+        return instance;
+    }
+    
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESCombatEvent* event, RE::BSTEventSource<RE::TESCombatEvent>*) override {
+        if (!event || !event->actor) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        auto actor = event->actor->As<RE::Actor>();
+        if (!actor) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kCombat, actor->GetFormID(),
+            event->targetActor ? event->targetActor->GetFormID() : 0, static_cast<std::uint32_t>(event->newState.get()));
+        
+        // Searching still counts as combat; only a return to kNone ends it
+        bool inCombat = event->newState.get() != RE::ACTOR_COMBAT_STATE::kNone;
+        PeriodicUpdateTask::GetSingleton()->OnCombatStateChanged(actor, inCombat);
+        
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    
+    void Register() {
+        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder) {
+            eventHolder->AddEventSink<RE::TESCombatEvent>(this);
+            logger::info("Registered combat event handler");
+        }
+    }
+};
+
+// Feeds the threat map with hits on the party, and drives strike effects and counters from the party's own hits
+class HitEventHandler : public RE::BSTEventSink<RE::TESHitEvent> {
+private:
+    static inline HitEventHandler* instance = nullptr;
+    
+    HitEventHandler() = default;
+    
+    // The game's side of RouteHit
+    struct GameHit {
+        const RE::TESHitEvent* event;
+        PeriodicUpdateTask* updateTask;
+        
+        bool MayBeStrike() const { return Settings::GetSingleton()->MayBeStrikeWeapon(event->source); }
+        RE::FormID VictimID() const { return event->target->GetFormID(); }
+        RE::FormID AttackerID() const { return event->cause->GetFormID(); }
+        bool IsPartyVictim(RE::FormID victimID) const { return updateTask->IsRegistered(victimID) || event->target->IsPlayerRef(); }
+        bool IsRegistered(RE::FormID formID) const { return updateTask->IsRegistered(formID); }
+        bool IsRecording() const { return EventLog::Recorder::GetSingleton()->IsRecording(); }
+        bool IsCounting() const { return Telemetry::IsCounting(); }
+        bool IsHeavy() const { return event->flags.any(RE::TESHitEvent::Flag::kPowerAttack, RE::TESHitEvent::Flag::kSneakAttack); }
+        bool IsBlocked() const { return event->flags.any(RE::TESHitEvent::Flag::kHitBlocked); }
+        
+        void Record(RE::FormID victimID, RE::FormID attackerID) const {
+            EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kHit, victimID, attackerID,
+                static_cast<std::uint32_t>(event->flags.underlying()), event->source);
+        }
+        
+        void Count(RE::FormID attackerID) const { Telemetry::Add(Telemetry::Counter::kHits, attackerID, event->source); }
+        
+        void Strike() const {
+            auto attacker = event->cause->As<RE::Actor>();
+            auto victim = event->target->As<RE::Actor>();
+            if (attacker && victim && attacker != victim) {
+                CombatClassesManager::GetSingleton()->OnStrikeHit(attacker, victim, event->source);
+            }
+        }
+        
+        void AddThreat(RE::FormID victimID, RE::FormID attackerID, float amount) const {
+            CombatClasses::ThreatMap::GetSingleton()->AddHit(victimID, attackerID, amount);
+        }
+    };
+
+public:
+    static HitEventHandler* GetSingleton() {
+        if (!instance) {
+            instance = new HitEventHandler();
+        }
+        return instance;
+    }
+    
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESHitEvent* event, RE::BSTEventSource<RE::TESHitEvent>*) override {
+        if (!event || !event->target || !event->cause) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        GameHit hit{ event, PeriodicUpdateTask::GetSingleton() };
+        RouteHit(hit);
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    
+    void Register() {
+        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder) {
+            eventHolder->AddEventSink<RE::TESHitEvent>(this);
+            logger::info("Registered hit event handler");
         }
     }
 };
@@ -173,12 +485,26 @@ public:
             return RE::BSEventNotifyControl::kContinue;
         }
         
-        auto actor = RE::TESForm::LookupByID<RE::Actor>(event->formID);
-        if (actor) {
-            CombatClassesManager::GetSingleton()->OnActorUnload(actor);
-            PeriodicUpdateTask::GetSingleton()->UnregisterActor(event->formID);
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kFormDelete, event->formID);
+        
+        // Nearly every deleted form is unrelated; the registration filter rejects those in one probe
+        auto updateTask = PeriodicUpdateTask::GetSingleton();
+        if (!updateTask->IsRegistered(event->formID)) {
+            // NPCs classed by a rule are the only other forms with state; the manager's filter turns away the rest
+            auto manager = CombatClassesManager::GetSingleton();
+            if (manager->IsTracked(event->formID)) {
+                manager->Forget(event->formID);
+            }
+            return RE::BSEventNotifyControl::kContinue;
         }
         
+        if (auto actor = updateTask->GetLoadedActor(event->formID)) {
+            CombatClassesManager::GetSingleton()->OnActorUnload(actor.get());
+        } else {
+            CombatClassesManager::GetSingleton()->Forget(event->formID);
+        }
+        updateTask->UnregisterActor(event->formID);
+        
         return RE::BSEventNotifyControl::kContinue;
     }
     
@@ -215,6 +541,8 @@ public:
             return RE::BSEventNotifyControl::kContinue;
         }
         
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kCellLoad, cell->GetFormID());
+        
         // Process actors in this cell
         const auto& refList = cell->GetRuntimeData().references;
         for (auto& ref : refList) {
@@ -226,6 +554,7 @@ public:
                     // Register for periodic updates if this is a follower
                     if (Settings::GetSingleton()->IsFollower(actor->GetFormID())) {
                         PeriodicUpdateTask::GetSingleton()->RegisterActor(actor->GetFormID());
+                        PeriodicUpdateTask::GetSingleton()->OnActorLoaded(actor);
                     }
                 }
             }
@@ -243,15 +572,149 @@ public:
     }
 };
 
-void RegisterHooks() {
+class ObjectLoadedEventHandler : public RE::BSTEventSink<RE::TESObjectLoadedEvent> {
+private:
+    static inline ObjectLoadedEventHandler* instance = nullptr;
+    
+    ObjectLoadedEventHandler() = default;
+
+public:
+    static ObjectLoadedEventHandler* GetSingleton() {
+        if (!instance) {
+            instance = new ObjectLoadedEventHandler();
+        }
+        return instance;
+    }
+    
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESObjectLoadedEvent* event, RE::BSTEventSource<RE::TESObjectLoadedEvent>*) override {
+        if (!event) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kObjectLoaded, event->formID, 0, event->loaded);
+        
+        auto updateTask = PeriodicUpdateTask::GetSingleton();
+        if (!updateTask->IsRegistered(event->formID)) {
+            HandleRuleActor(event);
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        if (event->loaded) {
+            // The only form lookup for a tracked actor; after this it is reached through its handle
+            auto actor = RE::TESForm::LookupByID<RE::Actor>(event->formID);
+            if (actor) {
+                CombatClassesManager::GetSingleton()->OnActorLoad(actor);
+                updateTask->OnActorLoaded(actor);
+            }
+        } else {
+            if (auto actor = updateTask->GetLoadedActor(event->formID)) {
+                CombatClassesManager::GetSingleton()->OnActorUnload(actor.get());
+            }
+            updateTask->OnActorUnloaded(event->formID);
+        }
+        
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    
+    void Register() {
+        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder) {
+            eventHolder->AddEventSink<RE::TESObjectLoadedEvent>(this);
+            logger::info("Registered object loaded event handler");
+        }
+    }
+
+private:
+    // NPCs outside the follower roster only matter when a class rule picks them up
+    void HandleRuleActor(const RE::TESObjectLoadedEvent* event) {
+        auto manager = CombatClassesManager::GetSingleton();
+        if (event->loaded) {
+            if (Settings::GetSingleton()->GetRuleTable().empty()) {
+                return;
+            }
+            if (auto actor = RE::TESForm::LookupByID<RE::Actor>(event->formID)) {
+                manager->OnActorLoad(actor);
+            }
+        } else if (manager->IsTracked(event->formID)) {
+            manager->OnActorUnload(RE::TESForm::LookupByID<RE::Actor>(event->formID));
+        }
+    }
+};
+
+class CellAttachDetachEventHandler : public RE::BSTEventSink<RE::TESCellAttachDetachEvent> {
+private:
+    static inline CellAttachDetachEventHandler* instance = nullptr;
+    
+    CellAttachDetachEventHandler() = default;
+
+public:
+    static CellAttachDetachEventHandler* GetSingleton() {
+        if (!instance) {
+            instance = new CellAttachDetachEventHandler();
+        }
+        return instance;
+    }
+    
+    RE::BSEventNotifyControl ProcessEvent(const RE::TESCellAttachDetachEvent* event, RE::BSTEventSource<RE::TESCellAttachDetachEvent>*) override {
+        if (!event || !event->reference) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        auto formID = event->reference->GetFormID();
+        EventLog::Recorder::GetSingleton()->Record(EventLog::RecordType::kCellAttachDetach, formID, 0, event->attached);
+        
+        // Attaching is handled when the 3D loads
+        if (event->attached) {
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        auto updateTask = PeriodicUpdateTask::GetSingleton();
+        if (!updateTask->IsRegistered(formID)) {
+            // Revert NPCs that picked up a class from a rule
+            auto manager = CombatClassesManager::GetSingleton();
+            if (manager->IsTracked(formID)) {
+                manager->OnActorUnload(event->reference->As<RE::Actor>());
+            }
+            return RE::BSEventNotifyControl::kContinue;
+        }
+        
+        if (auto actor = event->reference->As<RE::Actor>()) {
+            CombatClassesManager::GetSingleton()->OnActorUnload(actor);
+        }
+        updateTask->OnActorUnloaded(formID);
+        
+        return RE::BSEventNotifyControl::kContinue;
+    }
+    
+    void Register() {
+        RE::ScriptEventSourceHolder* eventHolder = RE::ScriptEventSourceHolder::GetSingleton();
+        if (eventHolder) {
+            eventHolder->AddEventSink<RE::TESCellAttachDetachEvent>(this);
+            logger::info("Registered cell attach/detach event handler");
+        }
+    }
+};
+
+// Attaches every sink. Deferred until settings track at least one form, so a load order that
+// configures nothing pays for no event dispatch at all. Safe to call repeatedly.
+inline void RegisterHooks() {
+    static bool registered = false;
+    if (registered) {
+        return;
+    }
+    registered = true;
+    
+    StartupProfile::ScopedPhase timer(StartupProfile::Phase::kSinkRegistration);
+    
     // Register event handlers
     EquipEventHandler::GetSingleton()->Register();
     LoadGameEventHandler::GetSingleton()->Register();
     FormDeleteEventHandler::GetSingleton()->Register();
     CellLoadEventHandler::GetSingleton()->Register();
-    
-    // Set up periodic updates
-    PeriodicUpdateTask::Register();
+    CombatEventHandler::GetSingleton()->Register();
+    HitEventHandler::GetSingleton()->Register();
+    ObjectLoadedEventHandler::GetSingleton()->Register();
+    CellAttachDetachEventHandler::GetSingleton()->Register();
     
     logger::info("All hooks registered");
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <span>
+#include "fixed_containers.h"
+
+// Which followers each fighting actor is hostile to, carried from one target refresh to the next.
+// IsHostileToActor walks faction relations, and asking it for every follower about every actor in
+// high process each tick cost more than the assignment it feeds. An actor is asked again when it
+// is first seen, when it picks a new combat target, and otherwise when its answer has aged out,
+// a few per refresh so a faction change still shows up within a second or so.
+namespace CombatClasses {
+    template <std::size_t MaxMembers>
+    class HostilityCache {
+    public:
+        static_assert(MaxMembers <= 16, "One bit per follower");
+
+        // Refreshes an unchanged answer is reused for, and how many aged answers are redone per refresh
+        static constexpr std::uint32_t maxAge = 60;
+        static constexpr std::size_t maxRechecks = 4;
+
+    private:
+        struct Entry {
+            RE::FormID targetID = 0;
+            std::uint32_t checkedAt = 0;
+            std::uint32_t seenAt = 0;
+            std::uint16_t hostileTo = 0;
+        };
+
+        // Sized for every combatant of a large battle; past that, actors are asked every time
+        FixedMap<RE::FormID, Entry, 512> entries;
+
+        // The bits are per member index, so any change to the members starts over
+        FixedVector<RE::FormID, MaxMembers> members;
+
+        std::uint32_t refresh = 0;
+        std::size_t rechecks = 0;
+
+        std::uint64_t hits = 0;
+        std::uint64_t checks = 0;
+
+    public:
+        void BeginRefresh(std::span<const RE::FormID> memberIDs) {
+            if (!std::ranges::equal(members, memberIDs)) {
+                entries.clear();
+                members.clear();
+                for (auto formID : memberIDs) {
+                    members.push_back(formID);
+                }
+            }
+            ++refresh;
+            rechecks = 0;
+        }
+
+        // Bit i set when the actor is hostile to member i. isHostileTo(i) asks the game.
+        template <class IsHostileTo>
+        std::uint16_t Get(RE::FormID formID, RE::FormID targetID, IsHostileTo&& isHostileTo) {
+            auto entry = entries.try_emplace(formID);
+            if (entry && entry->seenAt != 0 && entry->targetID == targetID) {
+                bool aged = refresh - entry->checkedAt >= maxAge;
+                if (!aged || rechecks == maxRechecks) {
+                    entry->seenAt = refresh;
+                    ++hits;
+                    return entry->hostileTo;
+                }
+                ++rechecks;
+            }
+
+            std::uint16_t hostileTo = 0;
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                if (isHostileTo(i)) {
+                    hostileTo |= static_cast<std::uint16_t>(1u << i);
+                }
+            }
+            ++checks;
+
+            if (entry) {
+                *entry = { targetID, refresh, refresh, hostileTo };
+            }
+            return hostileTo;
+        }
+
+        // Forgets actors that weren't asked about this refresh
+        void EndRefresh() {
+            auto current = refresh;
+            entries.erase_if([current](RE::FormID, const Entry& entry) { return entry.seenAt != current; });
+        }
+
+        void Clear() {
+            entries.clear();
+            members.clear();
+        }
+
+        std::uint64_t GetHits() const { return hits; }
+        std::uint64_t GetChecks() const { return checks; }
+    };
+}
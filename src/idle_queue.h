@@ -0,0 +1,158 @@
+#pragma once
+
+#include "fixed_containers.h"
+#include "settings.h"
+#include "util.h"
+
+// Idle and stagger requests collected over a frame and submitted together. Effects that want to drive an
+// actor's animation graph queue it here instead of calling AnimUtil::Idle::Play or notifying the graph
+// themselves, so several effects reacting to the same event produce one request per actor rather than
+// fighting over its graph.
+namespace AnimUtil {
+    enum class IdlePriority : std::uint8_t {
+        kLow,     // flavour, e.g. taunts
+        kNormal,  // effect reactions
+        kHigh     // staggers and anything that must play
+    };
+
+    class IdleQueue {
+    private:
+        static inline IdleQueue* instance = nullptr;
+
+        struct Request {
+            RE::ActorHandle actor;
+            RE::ActorHandle target;
+            RE::TESIdleForm* idle = nullptr;  // null for a stagger
+            RE::DEFAULT_OBJECT action = RE::DEFAULT_OBJECT::kActionIdle;
+            IdlePriority priority = IdlePriority::kNormal;
+            // Stagger only: direction as the graph expects it (0 to 1 around the actor) and strength
+            float staggerDirection = 0.0f;
+            float staggerMagnitude = 0.0f;
+        };
+
+        struct Cooldown {
+            std::chrono::steady_clock::time_point until;
+            IdlePriority priority = IdlePriority::kLow;
+        };
+
+        // One request per actor; a second one for the same actor merges into it
+        FixedVector<Request, 32> pending;
+
+        // Actors that played an idle recently. Only higher priority requests get through until it expires.
+        // Sized for everyone a fight can stagger at once; when it is full a new actor just goes without one.
+        FixedMap<RE::FormID, Cooldown, 128> cooldowns;
+
+        std::uint64_t mergedRequests = 0;
+        std::uint64_t droppedRequests = 0;
+        std::uint64_t executedRequests = 0;
+        std::uint64_t failedRequests = 0;
+
+        IdleQueue() = default;
+
+    public:
+        static IdleQueue* GetSingleton() {
+            if (!instance) {
+                instance = new IdleQueue();
+            }
+            return instance;
+        }
+
+        // Returns false if the request was dropped outright; a merged request still counts as queued
+        bool Queue(RE::Actor* actor, RE::TESIdleForm* idle, IdlePriority priority = IdlePriority::kNormal,
+            RE::Actor* target = nullptr, RE::DEFAULT_OBJECT action = RE::DEFAULT_OBJECT::kActionIdle) {
+            if (!actor || !idle) {
+                return false;
+            }
+
+            return Queue({ actor->GetHandle(), target ? target->GetHandle() : RE::ActorHandle{}, idle, action, priority }, actor->GetFormID());
+        }
+
+        // Staggers actor away from source, through the same graph variables the engine's stagger effects use
+        bool QueueStagger(RE::Actor* actor, RE::Actor* source, float magnitude, IdlePriority priority = IdlePriority::kHigh) {
+            if (!actor || !source || magnitude <= 0.0f) {
+                return false;
+            }
+
+            auto heading = actor->GetHeadingAngle(source->GetPosition(), false);
+            Request request{ actor->GetHandle(), source->GetHandle(), nullptr, RE::DEFAULT_OBJECT::kActionIdle, priority };
+            request.staggerDirection = heading >= 0.0f ? heading / 360.0f : (360.0f + heading) / 360.0f;
+            request.staggerMagnitude = magnitude;
+            return Queue(request, actor->GetFormID());
+        }
+
+        // Plays every surviving request. Called once per tick on the game thread.
+        void Flush() {
+            if (pending.empty()) {
+                return;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            auto cooldown = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<float>(Settings::GetSingleton()->GetIdleCooldown()));
+
+            for (const auto& request : pending) {
+                auto actor = request.actor.get();
+                if (!actor || actor->IsDead() || !actor->Is3DLoaded()) {
+                    ++droppedRequests;
+                    continue;
+                }
+
+                auto target = request.target.get();
+                auto played = request.idle ? Idle::Play(request.idle, actor.get(), request.action, target.get()) :
+                                             PlayStagger(actor.get(), request.staggerDirection, request.staggerMagnitude);
+                if (played) {
+                    ++executedRequests;
+                    if (auto slot = cooldowns.try_emplace(actor->GetFormID())) {
+                        *slot = { now + cooldown, request.priority };
+                    }
+                } else {
+                    ++failedRequests;
+                }
+            }
+            pending.clear();
+
+            cooldowns.erase_if([&](RE::FormID, const Cooldown& entry) { return entry.until <= now; });
+
+            logger::debug("Idles: {} executed, {} failed, {} merged, {} dropped in total",
+                executedRequests, failedRequests, mergedRequests, droppedRequests);
+        }
+
+        // Forgets queued requests and cooldowns, e.g. when the last fight ends
+        void Clear() {
+            pending.clear();
+            cooldowns.clear();
+        }
+
+    private:
+        bool Queue(const Request& request, RE::FormID formID) {
+            if (auto cooldown = cooldowns.find(formID)) {
+                if (std::chrono::steady_clock::now() < cooldown->until && request.priority <= cooldown->priority) {
+                    ++droppedRequests;
+                    return false;
+                }
+            }
+
+            if (auto it = std::ranges::find(pending, request.actor, &Request::actor); it != pending.end()) {
+                ++mergedRequests;
+                // Equal priority means the newer request describes the latest state, so it wins
+                if (request.priority < it->priority) {
+                    return true;
+                }
+                *it = request;
+                return true;
+            }
+
+            if (!pending.push_back(request)) {
+                ++droppedRequests;
+                return false;
+            }
+            return true;
+        }
+
+        static bool PlayStagger(RE::Actor* actor, float direction, float magnitude) {
+            actor->SetGraphVariableFloat(FixedStrings::Get(FixedStrings::ID::kStaggerDirection), direction);
+            actor->SetGraphVariableFloat(FixedStrings::Get(FixedStrings::ID::kStaggerMagnitude), magnitude);
+            return actor->NotifyAnimationGraph(FixedStrings::Get(FixedStrings::ID::kStaggerStart));
+        }
+    };
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "fixed_containers.h"
+#include "settings.h"
+
+// Shooter-to-target visibility, remembered per pair. A line of sight check is a raycast through the
+// physics world, so results are reused until either actor moves noticeably or the entry ages out, and
+// the checks that are needed run together once per tick under a per-frame cap.
+namespace CombatClasses {
+    class LineOfSightCache {
+    private:
+        static inline LineOfSightCache* instance = nullptr;
+
+        // Movement below this can't plausibly change what an archer sees
+        static constexpr float moveThresholdSquared = 32.0f * 32.0f;
+
+        struct Entry {
+            RE::ActorHandle shooter;
+            RE::ActorHandle target;
+            RE::NiPoint3 shooterPosition;
+            RE::NiPoint3 targetPosition;
+            std::chrono::steady_clock::time_point checkedAt;
+            bool visible = false;
+            bool known = false;
+            bool queued = false;
+        };
+
+        // Sized for the ranged pairs of a large fight; once full, further pairs stay unknown until entries expire
+        FixedMap<std::uint64_t, Entry, 1024> entries;
+
+        // Pairs waiting for a raycast, in the order they were first asked for
+        FixedVector<std::uint64_t, 64> pending;
+
+        // Bumped whenever a check changes what a caller would have assumed, so users of the results know to re-read them
+        std::uint32_t version = 0;
+
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t raycasts = 0;
+        std::uint64_t flips = 0;
+
+        LineOfSightCache() = default;
+
+    public:
+        static LineOfSightCache* GetSingleton() {
+            if (!instance) {
+                instance = new LineOfSightCache();
+            }
+            return instance;
+        }
+
+        // Cached visibility, or nullopt if there is no current result yet. A miss queues a check for this tick.
+        std::optional<bool> Query(RE::Actor* shooter, RE::Actor* target) {
+            auto key = Key(shooter->GetFormID(), target->GetFormID());
+            auto entry = entries.try_emplace(key);
+
+            // A full table just leaves the pair unknown, like one still waiting for its check
+            if (entry && IsCurrent(*entry, shooter, target)) {
+                ++hits;
+                return entry->visible;
+            }
+
+            ++misses;
+            if (entry && !entry->queued && pending.push_back(key)) {
+                entry->queued = true;
+                entry->shooter = shooter->GetHandle();
+                entry->target = target->GetHandle();
+            }
+            return std::nullopt;
+        }
+
+        // Runs the queued checks, at most the configured number per frame. Game thread, once per tick.
+        void Resolve() {
+            auto now = std::chrono::steady_clock::now();
+            auto budget = std::min<std::size_t>(pending.size(), Settings::GetSingleton()->GetMaxRaycastsPerFrame());
+
+            for (std::size_t i = 0; i < budget; ++i) {
+                auto found = entries.find(pending[i]);
+                if (!found) {
+                    continue;
+                }
+
+                auto& entry = *found;
+                entry.queued = false;
+                auto shooter = entry.shooter.get();
+                auto target = entry.target.get();
+                if (!shooter || !target) {
+                    entries.erase(pending[i]);
+                    continue;
+                }
+
+                bool unused = false;
+                bool visible = shooter->HasLineOfSight(target.get(), unused);
+                ++raycasts;
+
+                // Callers treat an unknown pair as visible, so a first result only matters if it is blocked
+                if (entry.known ? entry.visible != visible : !visible) {
+                    ++version;
+                    flips += entry.known;
+                }
+                entry.visible = visible;
+                entry.known = true;
+                entry.checkedAt = now;
+                entry.shooterPosition = shooter->GetPosition();
+                entry.targetPosition = target->GetPosition();
+            }
+
+            // The rest go first next frame
+            FixedVector<std::uint64_t, 64> remaining;
+            for (std::size_t i = budget; i < pending.size(); ++i) {
+                remaining.push_back(pending[i]);
+            }
+            pending = remaining;
+
+            // Pairs nobody asked about for a while are gone from the fight, and ones the queue had no room for are asked again
+            auto expiry = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(GetTTL() * 4.0f));
+            entries.erase_if([&](std::uint64_t, const Entry& entry) {
+                return !entry.queued && (!entry.known || now - entry.checkedAt > expiry);
+            });
+        }
+
+        std::uint32_t GetVersion() const { return version; }
+
+        void Clear() {
+            if (entries.empty()) {
+                return;
+            }
+            entries.clear();
+            pending.clear();
+
+            auto queries = hits + misses;
+            logger::debug("Line of sight: {} queries, {:.1f}% hits, {} raycasts, {} saved, {} flips",
+                queries, queries ? 100.0 * hits / queries : 0.0, raycasts, queries - raycasts, flips);
+        }
+
+    private:
+        static std::uint64_t Key(RE::FormID shooter, RE::FormID target) {
+            return (static_cast<std::uint64_t>(shooter) << 32) | target;
+        }
+
+        static float GetTTL() { return Settings::GetSingleton()->GetLineOfSightTTL(); }
+
+        static bool IsCurrent(const Entry& entry, RE::Actor* shooter, RE::Actor* target) {
+            if (!entry.known) {
+                return false;
+            }
+            if (std::chrono::steady_clock::now() - entry.checkedAt > std::chrono::duration<float>(GetTTL())) {
+                return false;
+            }
+            return entry.shooterPosition.GetSquaredDistance(shooter->GetPosition()) <= moveThresholdSquared &&
+                   entry.targetPosition.GetSquaredDistance(target->GetPosition()) <= moveThresholdSquared;
+        }
+    };
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Actor value modifiers as classes and bonus layers describe them. Kept apart from the class table so
+// the ledger that folds them depends on nothing but the actor value enum.
+namespace CombatClasses {
+    enum class ModifierOp : std::uint8_t {
+        kAdd,
+        kMultiply,
+        kSet
+    };
+
+    struct Modifier {
+        RE::ActorValue actorValue;
+        ModifierOp op;
+        float value;
+
+        bool operator==(const Modifier&) const = default;
+    };
+
+    // A modifier as written in the config, before the actor value name is resolved
+    struct RawModifier {
+        std::string actorValue;
+        ModifierOp op = ModifierOp::kAdd;
+        float value = 0.0f;
+    };
+
+    // Parses "+25", "-10", "*0.8" or "=0.5". A bare number is treated as an add. Any multiplier is fine,
+    // *0 included: removing a class drops its ledger layer and refolds from the base, nothing is divided out.
+    inline std::optional<RawModifier> ParseModifier(std::string_view key, std::string_view text) {
+        RawModifier modifier;
+        modifier.actorValue = key;
+
+        if (!text.empty()) {
+            switch (text.front()) {
+            case '*':
+                modifier.op = ModifierOp::kMultiply;
+                text.remove_prefix(1);
+                break;
+            case '=':
+                modifier.op = ModifierOp::kSet;
+                text.remove_prefix(1);
+                break;
+            case '+':
+                text.remove_prefix(1);
+                break;
+            }
+        }
+
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), modifier.value);
+        if (ec != std::errc{}) {
+            return std::nullopt;
+        }
+        return modifier;
+    }
+}
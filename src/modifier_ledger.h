@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+#include "modifier.h"
+
+namespace CombatClasses {
+    // Per-actor stack of modifier layers. Layers are folded in order over the value each actor value
+    // had before the ledger first touched it, and Flush writes only the values whose result changed.
+    // Changes made by anything else (level-ups, other mods, the console) are picked up at the next Flush
+    // and carried into the base, so they survive the refold.
+    class ModifierLedger {
+    public:
+        // One actor value the ledger has written over: what it held before any layer and what was last written
+        struct Capture {
+            RE::ActorValue actorValue;
+            float base;
+            float written;
+        };
+
+        enum Layer : std::uint8_t {
+            kBaseImprovement,
+            kBow,
+            kSpecialBow,
+            kWeaponProfile,
+            kClass,
+            kLayerCount
+        };
+
+    private:
+        struct Entry {
+            RE::ActorValue actorValue;
+            float base = 0.0f;
+            float written = 0.0f;
+            bool captured = false;
+            bool dirty = true;
+        };
+
+        std::array<std::vector<Modifier>, kLayerCount> layers;
+        std::uint8_t activeLayers = 0;
+        std::vector<Entry> entries;
+        bool dirty = false;
+
+    public:
+        bool HasLayer(Layer layer) const { return (activeLayers & (1u << layer)) != 0; }
+        bool IsDirty() const { return dirty; }
+        bool IsEmpty() const { return activeLayers == 0 && entries.empty(); }
+
+        void SetLayer(Layer layer, std::span<const Modifier> modifiers) {
+            if (HasLayer(layer) && std::ranges::equal(layers[layer], modifiers)) {
+                return;
+            }
+
+            MarkLayer(layer);
+            layers[layer].assign(modifiers.begin(), modifiers.end());
+            activeLayers |= static_cast<std::uint8_t>(1u << layer);
+            MarkLayer(layer);
+        }
+
+        void SetLayer(Layer layer, std::initializer_list<Modifier> modifiers) {
+            SetLayer(layer, std::span<const Modifier>(modifiers.begin(), modifiers.size()));
+        }
+
+        void ClearLayer(Layer layer) {
+            if (!HasLayer(layer)) {
+                return;
+            }
+
+            MarkLayer(layer);
+            layers[layer].clear();
+            activeLayers &= static_cast<std::uint8_t>(~(1u << layer));
+        }
+
+        // Drops every layer; the next Flush restores the original values
+        void Reset() {
+            for (std::uint8_t layer = 0; layer < kLayerCount; ++layer) {
+                ClearLayer(static_cast<Layer>(layer));
+            }
+        }
+
+        // Recomputes dirty actor values and writes each changed one exactly once.
+        // read(ActorValue) -> float fetches the current value, write(ActorValue, float) stores the result.
+        // Returns the number of writes issued.
+        template <class Read, class Write>
+        std::uint32_t Flush(Read&& read, Write&& write) {
+            if (!dirty) {
+                return 0;
+            }
+
+            std::uint32_t writes = 0;
+            for (auto it = entries.begin(); it != entries.end();) {
+                auto& entry = *it;
+                if (!entry.dirty) {
+                    ++it;
+                    continue;
+                }
+                entry.dirty = false;
+
+                auto current = read(entry.actorValue);
+                if (!entry.captured) {
+                    entry.base = current;
+                    entry.written = current;
+                    entry.captured = true;
+                } else if (current != entry.written) {
+                    // Moved by someone else since our last write; keep their change as part of the base
+                    entry.base += current - entry.written;
+                    entry.written = current;
+                }
+
+                bool referenced = false;
+                auto value = Evaluate(entry.actorValue, entry.base, referenced);
+
+                if (value != entry.written) {
+                    write(entry.actorValue, value);
+                    entry.written = value;
+                    ++writes;
+                }
+
+                // Nothing modifies this value any more and it is back at its base, so stop tracking it
+                if (!referenced) {
+                    it = entries.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+            dirty = false;
+            return writes;
+        }
+
+        // Visits every value the ledger has written over, for saving alongside the game
+        template <class Visit>
+        void ForEachCapture(Visit&& visit) const {
+            for (const auto& entry : entries) {
+                if (entry.captured) {
+                    visit(Capture{ entry.actorValue, entry.base, entry.written });
+                }
+            }
+        }
+
+        // The value a captured actor value returns to with every layer dropped. Whatever moved it since the
+        // ledger's write is kept, the same way Flush folds outside changes into the base.
+        static float Restore(const Capture& capture, float current) {
+            return capture.base + (current - capture.written);
+        }
+
+    private:
+        void MarkLayer(Layer layer) {
+            for (const auto& modifier : layers[layer]) {
+                Touch(modifier.actorValue);
+            }
+        }
+
+        void Touch(RE::ActorValue actorValue) {
+            dirty = true;
+            for (auto& entry : entries) {
+                if (entry.actorValue == actorValue) {
+                    entry.dirty = true;
+                    return;
+                }
+            }
+            entries.push_back({ actorValue });
+        }
+
+        float Evaluate(RE::ActorValue actorValue, float base, bool& referenced) const {
+            auto value = base;
+            for (std::uint8_t layer = 0; layer < kLayerCount; ++layer) {
+                if (!HasLayer(static_cast<Layer>(layer))) {
+                    continue;
+                }
+                for (const auto& modifier : layers[layer]) {
+                    if (modifier.actorValue != actorValue) {
+                        continue;
+                    }
+                    referenced = true;
+                    switch (modifier.op) {
+                    case ModifierOp::kAdd:
+                        value += modifier.value;
+                        break;
+                    case ModifierOp::kMultiply:
+                        value *= modifier.value;
+                        break;
+                    case ModifierOp::kSet:
+                        value = modifier.value;
+                        break;
+                    }
+                }
+            }
+            return value;
+        }
+    };
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "combat_classes.h"
+#include "event_replay.h"
+#include "hook.h"
+
+// Batch native API for mod authors. Every function takes an array so a script can drive a whole
+// party in one VM round trip instead of one yielding call per follower.
+namespace Papyrus {
+    inline constexpr auto scriptName = "CS_CombatClasses"sv;
+
+    // Number of floats GetFollowerStats returns per actor
+    inline constexpr std::size_t statsStride = 5;
+
+    // Registers actors as followers and initializes the ones that are loaded. Actors that are already registered
+    // are initialized again, e.g. when a script repeats its registration after a load. Returns how many were newly added.
+    inline std::int32_t RegisterFollowers(RE::StaticFunctionTag*, std::vector<RE::Actor*> actors) {
+        auto settings = Settings::GetSingleton();
+        auto manager = CombatClassesManager::GetSingleton();
+        auto updateTask = PeriodicUpdateTask::GetSingleton();
+
+        std::int32_t added = 0;
+        for (auto actor : actors) {
+            if (!actor) continue;
+
+            auto formID = actor->GetFormID();
+            if (settings->AddRuntimeFollower(formID)) {
+                ++added;
+            }
+
+            updateTask->RegisterActor(formID);
+            if (actor->Is3DLoaded()) {
+                manager->InitializeActor(actor);
+                updateTask->OnActorLoaded(actor);
+            }
+        }
+
+        // The first follower wakes the plugin up if nothing in the config did
+        if (settings->HasTrackedForms()) {
+            RegisterHooks();
+        }
+        
+        logger::info("Papyrus registered {} of {} followers", added, actors.size());
+        return added;
+    }
+
+    // Reverts and forgets actors previously added with RegisterFollowers. Returns how many were removed.
+    inline std::int32_t UnregisterFollowers(RE::StaticFunctionTag*, std::vector<RE::Actor*> actors) {
+        auto settings = Settings::GetSingleton();
+        auto manager = CombatClassesManager::GetSingleton();
+        auto updateTask = PeriodicUpdateTask::GetSingleton();
+
+        std::int32_t removed = 0;
+        for (auto actor : actors) {
+            if (!actor) continue;
+
+            auto formID = actor->GetFormID();
+            if (!settings->RemoveRuntimeFollower(formID)) continue;
+
+            manager->OnActorUnload(actor);
+            if (!settings->IsFollower(formID)) {
+                updateTask->UnregisterActor(formID);
+            }
+            ++removed;
+        }
+
+        logger::info("Papyrus unregistered {} of {} followers", removed, actors.size());
+        return removed;
+    }
+
+    // Switches every actor to the named combat class. Returns how many actors accepted it.
+    inline std::int32_t ApplyClass(RE::StaticFunctionTag*, std::vector<RE::Actor*> actors, RE::BSFixedString className) {
+        auto manager = CombatClassesManager::GetSingleton();
+
+        std::int32_t applied = 0;
+        for (auto actor : actors) {
+            if (manager->ApplyClass(actor, className.c_str())) {
+                ++applied;
+            }
+        }
+        return applied;
+    }
+
+    // Flattened stats, statsStride floats per actor in input order:
+    // Marksman, attackAngleMult, aimOffsetV, aimSightedDelay, combatHealthRegenMult.
+    // Entries for None actors are zero.
+    inline std::vector<float> GetFollowerStats(RE::StaticFunctionTag*, std::vector<RE::Actor*> actors) {
+        std::vector<float> stats(actors.size() * statsStride, 0.0f);
+
+        for (std::size_t i = 0; i < actors.size(); ++i) {
+            auto actor = actors[i];
+            if (!actor) continue;
+
+            auto out = stats.begin() + i * statsStride;
+            out[0] = actor->GetActorValueByName("Marksman");
+            out[1] = actor->GetActorValueByName("attackAngleMult");
+            out[2] = actor->GetActorValueByName("aimOffsetV");
+            out[3] = actor->GetActorValueByName("aimSightedDelay");
+            out[4] = actor->GetActorValueByName("combatHealthRegenMult");
+        }
+        return stats;
+    }
+
+    // Starts writing every plugin event to the event log in the SKSE log folder
+    inline bool StartEventRecording(RE::StaticFunctionTag*) {
+        if (!EventLog::Recorder::GetSingleton()->Start()) {
+            return false;
+        }
+        PeriodicUpdateTask::GetSingleton()->RecordState();
+        return true;
+    }
+    
+    inline void StopEventRecording(RE::StaticFunctionTag*) {
+        EventLog::Recorder::GetSingleton()->Stop();
+    }
+    
+    // Replays the event log on a worker through a detached follower roster; the game is not touched. Results go to the plugin log.
+    inline bool ReplayEventLog(RE::StaticFunctionTag*) {
+        auto taskInterface = SKSE::GetTaskInterface();
+        if (!taskInterface) {
+            return false;
+        }
+        // The recorder's state belongs to the game thread, and the file it writes is the one replay reads
+        taskInterface->AddTask([]() {
+            if (EventLog::Recorder::GetSingleton()->IsRecording()) {
+                logger::warn("Not replaying events while recording");
+                return;
+            }
+            ThreadPool::GetSingleton()->Submit([]() { EventLog::ReplayFile(); });
+        });
+        return true;
+    }
+    
+    inline bool Register(RE::BSScript::IVirtualMachine* vm) {
+        if (!vm) {
+            return false;
+        }
+
+        vm->RegisterFunction("RegisterFollowers"sv, scriptName, RegisterFollowers);
+        vm->RegisterFunction("UnregisterFollowers"sv, scriptName, UnregisterFollowers);
+        vm->RegisterFunction("ApplyClass"sv, scriptName, ApplyClass);
+        vm->RegisterFunction("GetFollowerStats"sv, scriptName, GetFollowerStats);
+        vm->RegisterFunction("StartEventRecording"sv, scriptName, StartEventRecording);
+        vm->RegisterFunction("StopEventRecording"sv, scriptName, StopEventRecording);
+        vm->RegisterFunction("ReplayEventLog"sv, scriptName, ReplayEventLog);
+
+        logger::info("Registered papyrus functions for {}", scriptName);
+        return true;
+    }
+}
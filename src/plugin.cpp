@@ -2,17 +2,35 @@
 #include "settings.h"
 #include "combat_classes.h"
 #include "hook.h"
+#include "papyrus.h"
+#include "serialization.h"
+
+// Runs on the game thread once settings are resolved. Nothing attaches until there is something to track.
+void OnSettingsLoaded()
+{
+    if (!Settings::GetSingleton()->HasTrackedForms()) {
+        logger::info("No followers or class rules configured, staying inactive");
+        return;
+    }
+    
+    RegisterHooks();
+    CombatClassesManager::GetSingleton()->Initialize();
+    PeriodicUpdateTask::Register();
+}
 
 void OnDataLoaded()
 {
     // Initialize our systems after all game data is loaded
     logger::info("Game data loaded, initializing Combat Classes");
     
-    // Load settings
-    Settings::GetSingleton()->LoadSettings();
+    // Intern every engine-facing string before anything can need one
+    FixedStrings::Registry::GetSingleton();
     
-    // Initialize the combat classes manager
-    CombatClassesManager::GetSingleton()->Initialize();
+    // Parse settings on a worker, then initialize the combat classes manager on the game thread
+    Settings::GetSingleton()->LoadSettingsAsync([]() {
+        OnSettingsLoaded();
+        StartupProfile::Report();
+    });
 }
 
 void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
@@ -22,39 +40,45 @@ void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
         OnDataLoaded();
         break;
     case SKSE::MessagingInterface::kPostLoad:
-        // Register hooks and event sinks after SKSE plugins are loaded
-        RegisterHooks();
+        // Event sinks are attached lazily, once settings track at least one form
         break;
     case SKSE::MessagingInterface::kPreLoadGame:
+        // Before the save's scripts run OnPlayerLoadGame, which is where they register their followers again
+        PeriodicUpdateTask::GetSingleton()->ForgetRuntimeFollowers();
         break;
     case SKSE::MessagingInterface::kPostLoadGame:
         // Handle post-load game events
-        Settings::GetSingleton()->LoadSettings();
-        CombatClassesManager::GetSingleton()->Initialize();
+        Settings::GetSingleton()->LoadSettingsAsync(OnSettingsLoaded);
         break;
     case SKSE::MessagingInterface::kNewGame:
-        // Handle new game
-        Settings::GetSingleton()->LoadSettings();
+        // No load game event comes for a new game, so drop the previous session's actors here. The reload
+        // also supersedes any load still in flight, so it has to finish the same way or the sinks never attach.
+        PeriodicUpdateTask::GetSingleton()->ForgetRuntimeFollowers();
+        PeriodicUpdateTask::GetSingleton()->Reset();
+        Settings::GetSingleton()->LoadSettingsAsync(OnSettingsLoaded);
         break;
     }
 }
 
 SKSEPluginLoad(const SKSE::LoadInterface *skse) {
     SKSE::Init(skse);
-    SetupLog();
+    {
+        StartupProfile::ScopedPhase timer(StartupProfile::Phase::kLogSetup);
+        SetupLog();
+    }
 
     logger::info("CS_CombatClasses v{} loading...", SKSE::PluginDeclaration::GetSingleton()->GetVersion().string());
     
     // Initialize papyrus interface
     auto papyrus = SKSE::GetPapyrusInterface();
-    if (!papyrus->Register([](RE::BSScript::IVirtualMachine* /*vm*/) { 
-        // You can register any papyrus native functions here if needed
-        return true;
-    })) {
+    if (!papyrus->Register(Papyrus::Register)) {
         logger::error("Failed to register papyrus functions");
         return false;
     }
 
+    // Captured actor values ride along with each save so bonuses don't compound across loads
+    Serialization::Register();
+
     auto messaging = SKSE::GetMessagingInterface();
     if (!messaging->RegisterListener("SKSE", MessageHandler)) {
         return false;
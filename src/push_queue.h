@@ -0,0 +1,56 @@
+#pragma once
+
+#include "fixed_containers.h"
+
+// Knockbacks collected over a tick and dispatched in a batch, at most a set number per frame. A target
+// already waiting for a push isn't queued again, since a second push in the same ragdoll only stacks.
+// What the cap holds back keeps its place for the next frame; what doesn't fit at all is dropped.
+template <class Handle, std::size_t N>
+class PushQueue {
+public:
+    struct Push {
+        Handle source;
+        Handle target;
+        float magnitude;
+    };
+
+private:
+    FixedVector<Push, N> pending;
+    std::uint64_t dispatched = 0;
+    std::uint64_t deferred = 0;
+    std::uint64_t dropped = 0;
+
+public:
+    // False when the target was already queued or the queue is full
+    bool Queue(const Handle& source, const Handle& target, float magnitude) {
+        if (std::ranges::find(pending, target, &Push::target) != pending.end()) {
+            return false;
+        }
+        if (!pending.push_back({ source, target, magnitude })) {
+            ++dropped;
+            return false;
+        }
+        return true;
+    }
+
+    // Hands up to maxPushes of the oldest pushes to dispatch(push), which returns whether one went out,
+    // and moves the rest to the front
+    template <class Dispatch>
+    void Flush(std::size_t maxPushes, Dispatch&& dispatch) {
+        auto budget = std::min(pending.size(), maxPushes);
+        for (std::size_t i = 0; i < budget; ++i) {
+            dispatched += dispatch(std::as_const(pending[i]));
+        }
+
+        pending.erase_front(budget);
+        deferred += pending.size();
+    }
+
+    void clear() { pending.clear(); }
+    bool empty() const { return pending.empty(); }
+    std::size_t size() const { return pending.size(); }
+
+    std::uint64_t GetDispatched() const { return dispatched; }
+    std::uint64_t GetDeferred() const { return deferred; }
+    std::uint64_t GetDropped() const { return dropped; }
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <bitset>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "class_id.h"
+
+// The game-free half of the class rules: predicate bits over form IDs, levels and weapon conditions, and
+// the first-match scan over compiled rules. RuleTable resolves config entries to form IDs and reads actors
+// into these calls.
+namespace CombatClasses {
+    inline constexpr std::size_t kMaxRuleAtoms = 256;
+    using RuleBits = std::bitset<kMaxRuleAtoms>;
+
+    // A rule with its form references resolved. An empty list places no condition.
+    struct ResolvedRule {
+        std::string_view name;
+        ClassID classID = kNoClass;
+        std::vector<RE::FormID> factions;
+        std::vector<RE::FormID> races;
+        std::vector<RE::FormID> keywords;
+        std::uint16_t minLevel = 0;
+        std::uint16_t maxLevel = 0;
+        std::optional<WeaponCondition> weapon;
+    };
+
+    class RuleMatcher {
+    private:
+        struct CompiledRule {
+            RuleBits required;
+            ClassID classID;
+        };
+
+        struct LevelAtom {
+            std::uint16_t minLevel;
+            std::uint16_t maxLevel;
+            std::size_t bit;
+        };
+
+        struct WeaponAtom {
+            WeaponCondition condition;
+            std::size_t bit;
+        };
+
+        // Which bits a given faction, race or keyword switches on
+        std::unordered_map<RE::FormID, RuleBits> factionBits;
+        std::unordered_map<RE::FormID, RuleBits> raceBits;
+        std::unordered_map<RE::FormID, RuleBits> keywordBits;
+        std::vector<LevelAtom> levelAtoms;
+        std::vector<WeaponAtom> weaponAtoms;
+
+        // In the order added; the first match wins
+        std::vector<CompiledRule> rules;
+        std::size_t atomCount = 0;
+
+    public:
+        bool empty() const { return rules.empty(); }
+        std::size_t size() const { return rules.size(); }
+        std::size_t atoms() const { return atomCount; }
+
+        bool UsesFactions() const { return !factionBits.empty(); }
+        bool UsesRaces() const { return !raceBits.empty(); }
+        bool UsesKeywords() const { return !keywordBits.empty(); }
+        bool UsesLevels() const { return !levelAtoms.empty(); }
+        bool UsesWeapons() const { return !weaponAtoms.empty(); }
+
+        void Clear() {
+            factionBits.clear();
+            raceBits.clear();
+            keywordBits.clear();
+            levelAtoms.clear();
+            weaponAtoms.clear();
+            rules.clear();
+            atomCount = 0;
+        }
+
+        // Assigns the rule's predicate bits. False, with nothing assigned, when they would not fit.
+        bool Add(const ResolvedRule& rule) {
+            bool levelled = rule.minLevel > 0 || rule.maxLevel > 0;
+            bool armed = rule.weapon && *rule.weapon != WeaponCondition::kAny;
+            auto sharedWeapon = armed ? std::ranges::find(weaponAtoms, *rule.weapon, &WeaponAtom::condition) : weaponAtoms.end();
+
+            auto needed = static_cast<std::size_t>(!rule.factions.empty()) + !rule.races.empty() + !rule.keywords.empty() + levelled +
+                          (armed && sharedWeapon == weaponAtoms.end());
+            if (atomCount + needed > kMaxRuleAtoms) {
+                logger::error("Rule {}: more than {} predicates in total", rule.name, kMaxRuleAtoms);
+                return false;
+            }
+
+            CompiledRule compiled{ {}, rule.classID };
+            auto addFormAtom = [&](const std::vector<RE::FormID>& formIDs, std::unordered_map<RE::FormID, RuleBits>& bitsByForm) {
+                if (formIDs.empty()) {
+                    return;
+                }
+                auto bit = atomCount++;
+                for (auto formID : formIDs) {
+                    bitsByForm[formID].set(bit);
+                }
+                compiled.required.set(bit);
+            };
+
+            addFormAtom(rule.factions, factionBits);
+            addFormAtom(rule.races, raceBits);
+            addFormAtom(rule.keywords, keywordBits);
+
+            if (levelled) {
+                std::uint16_t maxLevel = rule.maxLevel > 0 ? rule.maxLevel : UINT16_MAX;
+                levelAtoms.push_back({ rule.minLevel, maxLevel, atomCount });
+                compiled.required.set(atomCount++);
+            }
+
+            // Weapon conditions are shared between rules, one bit each
+            if (armed) {
+                if (sharedWeapon != weaponAtoms.end()) {
+                    compiled.required.set(sharedWeapon->bit);
+                } else {
+                    weaponAtoms.push_back({ *rule.weapon, atomCount });
+                    compiled.required.set(atomCount++);
+                }
+            }
+
+            rules.push_back(compiled);
+            return true;
+        }
+
+        void AddFaction(RuleBits& bits, RE::FormID formID) const { Lookup(bits, factionBits, formID); }
+        void AddRace(RuleBits& bits, RE::FormID formID) const { Lookup(bits, raceBits, formID); }
+        void AddKeyword(RuleBits& bits, RE::FormID formID) const { Lookup(bits, keywordBits, formID); }
+
+        void AddLevel(RuleBits& bits, std::uint16_t level) const {
+            for (const auto& atom : levelAtoms) {
+                if (level >= atom.minLevel && level <= atom.maxLevel) {
+                    bits.set(atom.bit);
+                }
+            }
+        }
+
+        // matches(condition) tells whether the actor's drawn weapon satisfies a condition
+        template <class Matches>
+        void AddWeapon(RuleBits& bits, Matches&& matches) const {
+            for (const auto& atom : weaponAtoms) {
+                if (matches(atom.condition)) {
+                    bits.set(atom.bit);
+                }
+            }
+        }
+
+        // Class of the first rule whose bits are all set, or kNoClass
+        ClassID Match(const RuleBits& bits) const {
+            for (const auto& rule : rules) {
+                if ((bits & rule.required) == rule.required) {
+                    return rule.classID;
+                }
+            }
+            return kNoClass;
+        }
+
+    private:
+        static void Lookup(RuleBits& bits, const std::unordered_map<RE::FormID, RuleBits>& bitsByForm, RE::FormID formID) {
+            if (auto it = bitsByForm.find(formID); it != bitsByForm.end()) {
+                bits |= it->second;
+            }
+        }
+    };
+}
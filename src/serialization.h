@@ -0,0 +1,103 @@
+#pragma once
+
+#include "combat_classes.h"
+
+// Bonuses are written into base actor values, and the game saves those with the actor. The co-save keeps
+// what each value held before the ledger touched it, so a load can take the bonuses back off and the new
+// session applies them once instead of stacking them on the saved result.
+namespace Serialization {
+    inline constexpr std::uint32_t kUniqueID = 'CSCC';
+    inline constexpr std::uint32_t kLedgerRecord = 'LDGR';
+    inline constexpr std::uint32_t kLedgerVersion = 1;
+
+    using Capture = CombatClasses::ModifierLedger::Capture;
+
+    // Per actor: form ID, capture count, then actor value, base and written value for each capture
+    inline void OnSave(SKSE::SerializationInterface* serialization) {
+        if (!serialization->OpenRecord(kLedgerRecord, kLedgerVersion)) {
+            logger::error("Could not open the ledger record in the co-save");
+            return;
+        }
+
+        std::size_t saved = 0;
+        CombatClassesManager::GetSingleton()->ForEachLedger([&](RE::FormID formID, const CombatClasses::ModifierLedger& ledger) {
+            std::uint32_t count = 0;
+            ledger.ForEachCapture([&](const Capture&) { ++count; });
+            if (count == 0) {
+                return;
+            }
+
+            serialization->WriteRecordData(formID);
+            serialization->WriteRecordData(count);
+            ledger.ForEachCapture([&](const Capture& capture) {
+                serialization->WriteRecordData(static_cast<std::uint32_t>(capture.actorValue));
+                serialization->WriteRecordData(capture.base);
+                serialization->WriteRecordData(capture.written);
+            });
+            ++saved;
+        });
+
+        logger::info("Saved captured actor values for {} actors", saved);
+    }
+
+    // Puts every saved actor value back to what it was before the bonuses, keeping whatever else moved it
+    inline void RestoreLedgers(SKSE::SerializationInterface* serialization) {
+        std::size_t restored = 0;
+        RE::FormID savedID = 0;
+        while (serialization->ReadRecordData(savedID)) {
+            std::uint32_t count = 0;
+            if (!serialization->ReadRecordData(count)) {
+                logger::error("Ledger record ends early");
+                return;
+            }
+
+            RE::FormID formID = 0;
+            auto actor = serialization->ResolveFormID(savedID, formID) ? RE::TESForm::LookupByID<RE::Actor>(formID) : nullptr;
+            auto values = actor ? actor->AsActorValueOwner() : nullptr;
+
+            for (std::uint32_t i = 0; i < count; ++i) {
+                std::uint32_t actorValue = 0;
+                Capture capture{};
+                if (!serialization->ReadRecordData(actorValue) || !serialization->ReadRecordData(capture.base) ||
+                    !serialization->ReadRecordData(capture.written)) {
+                    logger::error("Ledger record ends early");
+                    return;
+                }
+
+                // The actor's plugin may be gone from the load order; its values went with it
+                if (!values) {
+                    continue;
+                }
+                capture.actorValue = static_cast<RE::ActorValue>(actorValue);
+                values->SetBaseActorValue(capture.actorValue,
+                    CombatClasses::ModifierLedger::Restore(capture, values->GetBaseActorValue(capture.actorValue)));
+            }
+            restored += values != nullptr;
+        }
+
+        logger::info("Restored captured actor values for {} actors", restored);
+    }
+
+    inline void OnLoad(SKSE::SerializationInterface* serialization) {
+        std::uint32_t type = 0;
+        std::uint32_t version = 0;
+        std::uint32_t length = 0;
+        while (serialization->GetNextRecordInfo(type, version, length)) {
+            if (type != kLedgerRecord) {
+                continue;
+            }
+            if (version != kLedgerVersion) {
+                logger::warn("Skipping ledger record version {}, expected {}", version, kLedgerVersion);
+                continue;
+            }
+            RestoreLedgers(serialization);
+        }
+    }
+
+    inline void Register() {
+        auto serialization = SKSE::GetSerializationInterface();
+        serialization->SetUniqueID(kUniqueID);
+        serialization->SetSaveCallback(OnSave);
+        serialization->SetLoadCallback(OnLoad);
+    }
+}
@@ -1,496 +1,431 @@
 #pragma once
 
-#include "settings.h"
-
-// Add ActorValue enum if it's not defined
-namespace AV {
-    enum ActorValue {
-        kMarksman = 8,
-        kAttackAngleMult = 96,
-        kAimOffset_V = 96 + 1,       // Adjust as needed based on your CommonLibSSE
-        kAimSightedDelay = 96 + 2,    // Adjust as needed
-        kCombatHealthRegenMult = 96 + 3  // Adjust as needed
-    };
-}
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "class_rules.h"
+#include "combat_class_table.h"
+#include "fixed_containers.h"
+#include "startup_profile.h"
+#include "telemetry.h"
+#include "text.h"
+#include "thread_pool.h"
+#include "threat_map.h"
+#include "weapon_profiles.h"
 
-class CombatClassesManager {
+class Settings {
 private:
-    static inline CombatClassesManager* instance = nullptr;
-    
-    // Track actor state
-    struct ActorState {
-        bool improvementsApplied = false;
-        bool hasSpecialBowBonus = false;
-        bool swordKnockbackActive = false;
-        float originalMarksman = 0.0f;
-        float originalAttackAngleMult = 1.0f;
-        float originalAimOffsetV = 1.0f;
-        float originalAimSightedDelay = 0.25f;
-        float originalCombatHealthRegenMult = 1.0f;
-        RE::FormID equippedBowID = 0;
-        RE::FormID equippedSwordID = 0;
-        std::chrono::steady_clock::time_point lastKnockbackTime;
+    static inline Settings* instance = nullptr;
+
+    static constexpr auto settingsPath = "Data/SKSE/Plugins/CS_CombatClasses/Settings.ini"sv;
+
+public:
+    // A form reference as written in the config, before it is resolved against the load order
+    struct FormEntry {
+        std::string name;
+        std::string plugin;
+        std::uint32_t localFormID = 0;
+        bool enabled = true;
+        std::string className;
     };
-    
-    // Maps actor formIDs to their state
-    std::unordered_map<RE::FormID, ActorState> actorStates;
-    
-    CombatClassesManager() = default;
+
+    // Everything read from Settings.ini. Parsing this touches no game state, so it can run on a worker.
+    struct Snapshot {
+        float baseAccuracyBonus = 30.0f;
+        float attackAngleMult = 0.5f;
+        float aimOffsetV = 0.85f;
+        float aimSightedDelay = 0.1f;
+        bool autoApplyImprovements = true;
+        float bowAccuracyBonus = 20.0f;
+        float specialBowBonus = 15.0f;
+        float bowAttackAngleScale = 0.8f;
+        float specialBowAttackAngleScale = 0.6f;
+        float combatHealthRegenMult = 2.0f;
+        float knockbackMagnitude = 1000.0f;
+        float knockbackInterval = 10.0f;
+        float knockbackRadius = 0.0f;
+        float knockbackConeAngle = 360.0f;
+        std::uint32_t knockbackMaxTargets = 4;
+        std::uint32_t maxPushesPerFrame = 8;
+        float idleCooldown = 0.5f;
+        bool coordinateTargets = true;
+        float targetSearchRadius = 4096.0f;
+        std::uint32_t targetBudgetMicros = 200;
+        float lineOfSightTTL = 0.5f;
+        std::uint32_t maxRaycastsPerFrame = 8;
+        float threatHalfLife = 10.0f;
+        bool strikeOnHit = true;
+        std::uint32_t telemetryInterval = 0;
+        Telemetry::Format telemetryFormat = Telemetry::Format::kJSON;
+
+        std::vector<FormEntry> followers;
+        std::vector<FormEntry> specialBows;
+        std::vector<FormEntry> specialSwords;
+        std::vector<CombatClasses::RawClass> classes;
+        std::vector<CombatClasses::RawRule> rules;
+        std::vector<CombatClasses::RawWeaponProfile> weaponProfiles;
+    };
+
+private:
+    Snapshot config;
+
+    // Resolved runtime FormIDs
+    std::unordered_map<std::string, RE::FormID> followers;
+    std::unordered_set<RE::FormID> enabledFollowers;
+    std::unordered_set<RE::FormID> followerIDs;
+    std::unordered_set<RE::FormID> specialBows;
+    std::unordered_set<RE::FormID> specialSwords;
+    std::unordered_map<RE::FormID, CombatClasses::ClassID> followerClasses;
+
+    // Special swords and weapons whose profile has a strike effect. Hit events check their source weapon
+    // here first, so hits with anything else are turned away in one probe.
+    FormIDFilter<8192> strikeWeaponFilter;
+
+    CombatClasses::ClassTable classTable;
+    CombatClasses::RuleTable ruleTable;
+    CombatClasses::WeaponProfileTable weaponProfiles;
+
+    // Followers registered at runtime through the Papyrus API. Not part of the config, so they survive settings
+    // reloads, but not a game load: they belong to the save whose scripts registered them.
+    std::unordered_set<RE::FormID> runtimeFollowers;
+
+    // Bumped on every load request so a slow parse can't overwrite a newer one
+    std::uint32_t loadGeneration = 0;
+
+    // Bumped every time a snapshot goes live, so caches derived from the config know to rebuild
+    std::uint32_t appliedGeneration = 0;
+
+    Settings() = default;
 
 public:
-    static CombatClassesManager* GetSingleton() {
+    static Settings* GetSingleton() {
         if (!instance) {
-            instance = new CombatClassesManager();
+            instance = new Settings();
         }
         return instance;
     }
-    
-    void Initialize() {
-        logger::info("Initializing Combat Classes Manager");
-        
-        // Initialize for all followers that are already loaded
-        auto dataHandler = RE::TESDataHandler::GetSingleton();
-        if (!dataHandler) {
-            logger::error("Failed to get data handler");
-            return;
+
+    static Snapshot Parse(const std::filesystem::path& path) {
+        StartupProfile::ScopedPhase timer(StartupProfile::Phase::kSettingsParse);
+        Snapshot snapshot;
+
+        Text::IniDocument ini;
+        if (!ini.Load(path)) {
+            logger::warn("Could not read {}, using defaults", path.string());
+            return snapshot;
         }
-        
-        const auto& settings = Settings::GetSingleton();
-        const auto& followers = settings->GetFollowers();
-        
-        for (const auto& [name, formID] : followers) {
-            if (settings->IsFollowerEnabled(formID)) {
-                auto actor = RE::TESForm::LookupByID<RE::Actor>(formID);
-                if (actor && actor->Is3DLoaded()) {
-                    logger::info("Initializing follower: {}", name);
-                    ApplyAccuracyImprovements(actor);
-                    
-                    // Check if they already have equipment
-                    auto rightHand = actor->GetEquippedObject(false);
-                    if (rightHand) {
-                        auto weapon = rightHand->As<RE::TESObjectWEAP>();
-                        if (weapon) {
-                            HandleWeaponEquipped(actor, weapon);
-                        }
-                    }
+
+        if (auto general = ini.FindSection("General"sv)) {
+            auto getFloat = [&](std::string_view key, float fallback) {
+                return general->GetNumber<float>(key, fallback);
+            };
+
+            snapshot.baseAccuracyBonus = getFloat("fBaseAccuracyBonus", snapshot.baseAccuracyBonus);
+            snapshot.attackAngleMult = getFloat("fAttackAngleMult", snapshot.attackAngleMult);
+            snapshot.aimOffsetV = getFloat("fAimOffsetV", snapshot.aimOffsetV);
+            snapshot.aimSightedDelay = getFloat("fAimSightedDelay", snapshot.aimSightedDelay);
+            snapshot.autoApplyImprovements = general->GetBool("bAutoApplyImprovements", snapshot.autoApplyImprovements);
+            snapshot.bowAccuracyBonus = getFloat("fBowAccuracyBonus", snapshot.bowAccuracyBonus);
+            snapshot.specialBowBonus = getFloat("fSpecialBowBonus", snapshot.specialBowBonus);
+            snapshot.bowAttackAngleScale = getFloat("fBowAttackAngleScale", snapshot.bowAttackAngleScale);
+            snapshot.specialBowAttackAngleScale = getFloat("fSpecialBowAttackAngleScale", snapshot.specialBowAttackAngleScale);
+            snapshot.combatHealthRegenMult = getFloat("fCombatHealthRegenMult", snapshot.combatHealthRegenMult);
+            snapshot.knockbackMagnitude = getFloat("fKnockbackMagnitude", snapshot.knockbackMagnitude);
+            snapshot.knockbackInterval = getFloat("fKnockbackInterval", snapshot.knockbackInterval);
+            snapshot.knockbackRadius = getFloat("fKnockbackRadius", snapshot.knockbackRadius);
+            snapshot.knockbackConeAngle = std::clamp(getFloat("fKnockbackConeAngle", snapshot.knockbackConeAngle), 0.0f, 360.0f);
+            snapshot.knockbackMaxTargets = std::max(general->GetNumber<std::uint32_t>("iKnockbackMaxTargets", snapshot.knockbackMaxTargets), 1u);
+            snapshot.maxPushesPerFrame = std::max(general->GetNumber<std::uint32_t>("iMaxPushesPerFrame", snapshot.maxPushesPerFrame), 1u);
+            snapshot.idleCooldown = std::max(getFloat("fIdleCooldown", snapshot.idleCooldown), 0.0f);
+            snapshot.coordinateTargets = general->GetBool("bCoordinateTargets", snapshot.coordinateTargets);
+            snapshot.targetSearchRadius = getFloat("fTargetSearchRadius", snapshot.targetSearchRadius);
+            snapshot.targetBudgetMicros = general->GetNumber<std::uint32_t>("iTargetBudgetMicros", snapshot.targetBudgetMicros);
+            snapshot.lineOfSightTTL = std::max(getFloat("fLineOfSightTTL", snapshot.lineOfSightTTL), 0.0f);
+            snapshot.maxRaycastsPerFrame = std::max(general->GetNumber<std::uint32_t>("iMaxRaycastsPerFrame", snapshot.maxRaycastsPerFrame), 1u);
+            snapshot.threatHalfLife = std::max(getFloat("fThreatHalfLife", snapshot.threatHalfLife), 0.0f);
+            snapshot.strikeOnHit = general->GetBool("bStrikeOnHit", snapshot.strikeOnHit);
+            snapshot.telemetryInterval = general->GetNumber<std::uint32_t>("iTelemetryInterval", snapshot.telemetryInterval);
+
+            if (auto format = general->Find("sTelemetryFormat"sv)) {
+                if (Text::IEquals(*format, "csv"sv)) {
+                    snapshot.telemetryFormat = Telemetry::Format::kCSV;
+                } else if (!Text::IEquals(*format, "json"sv)) {
+                    logger::warn("sTelemetryFormat: unknown format '{}', using json", *format);
                 }
             }
         }
-    }
-    
-    void OnActorEquip(RE::Actor* actor, RE::TESBoundObject* object) {
-        if (!actor || !object) return;
-        
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID())) return;
-        
-        auto weapon = object->As<RE::TESObjectWEAP>();
-        if (weapon) {
-            HandleWeaponEquipped(actor, weapon);
-        }
-    }
-    
-    void OnActorUnequip(RE::Actor* actor, RE::TESBoundObject* object) {
-        if (!actor || !object) return;
-        
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID())) return;
-        
-        auto weapon = object->As<RE::TESObjectWEAP>();
-        if (weapon) {
-            HandleWeaponUnequipped(actor, weapon);
-        }
-    }
-    
-    void OnActorLoad(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        if (settings->IsFollower(actor->GetFormID()) && settings->IsFollowerEnabled(actor->GetFormID())) {
-            logger::info("Follower loaded: {}", actor->GetName());
-            
-            if (settings->GetAutoApplyImprovements()) {
-                ApplyAccuracyImprovements(actor);
+
+        for (const auto& section : ini.GetSections()) {
+            auto sectionName = section.name;
+            auto separator = sectionName.find(':');
+            if (separator == std::string_view::npos) {
+                continue;
             }
-        }
-    }
-    
-    void OnActorUnload(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        if (settings->IsFollower(actor->GetFormID())) {
-            logger::info("Follower unloaded: {}", actor->GetName());
-            
-            RemoveAccuracyImprovements(actor);
-            RemoveBowBonus(actor);
-            RemoveSpecialBowBonus(actor);
-            StopSwordKnockback(actor);
-            
-            // Remove from tracking
-            actorStates.erase(actor->GetFormID());
-        }
-    }
-    
-    void Update(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        if (!settings->IsFollower(actor->GetFormID()) || !settings->IsFollowerEnabled(actor->GetFormID())) {
-            return;
-        }
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        if (it == actorStates.end()) {
-            return;
-        }
-        
-        auto& state = it->second;
-        
-        // Handle sword knockback
-        if (state.swordKnockbackActive && state.equippedSwordID != 0) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - state.lastKnockbackTime).count();
-            
-            if (elapsed >= settings->GetKnockbackInterval()) {
-                // Time to do knockback
-                HandleSwordKnockback(actor);
-                state.lastKnockbackTime = now;
+
+            auto kind = sectionName.substr(0, separator);
+            auto name = sectionName.substr(separator + 1);
+            if (kind == "Class"sv) {
+                snapshot.classes.push_back(ParseClass(section, name));
+                continue;
             }
-        }
-    }
-    
-private:
-    void HandleWeaponEquipped(RE::Actor* actor, RE::TESObjectWEAP* weapon) {
-        auto settings = Settings::GetSingleton();
-        auto weaponID = weapon->GetFormID();
-        auto actorID = actor->GetFormID();
-        
-        // Get or create actor state
-        auto& state = actorStates[actorID];
-        
-        // Check weapon type
-        if (weapon->GetWeaponType() == RE::WEAPON_TYPE::kBow) {
-            // Apply bow bonus
-            ApplyBowBonus(actor);
-            state.equippedBowID = weaponID;
-            
-            // Check if it's a special bow
-            if (settings->IsSpecialBow(weaponID)) {
-                ApplySpecialBowBonus(actor);
-                
-                // Notify player if the follower is player's follower
-                if (actor->IsPlayerTeammate()) {
-                    auto name = weapon->GetName();
-                    RE::DebugNotification(fmt::format("{}'s Improved Aim Activated", name).c_str());
+            if (kind == "WeaponProfile"sv) {
+                snapshot.weaponProfiles.push_back(ParseWeaponProfile(section, name));
+                continue;
+            }
+            if (kind == "Rule"sv) {
+                if (auto rule = ParseRule(section, name)) {
+                    snapshot.rules.push_back(std::move(*rule));
                 }
+                continue;
             }
-        } else if (settings->IsSpecialSword(weaponID)) {
-            // It's a special sword, start the knockback effect
-            StartSwordKnockback(actor);
-            state.equippedSwordID = weaponID;
-            
-            // Notify player if the follower is player's follower
-            if (actor->IsPlayerTeammate()) {
-                auto name = weapon->GetName();
-                RE::DebugNotification(fmt::format("{}'s Knockback Power Activated", name).c_str());
+
+            FormEntry entry;
+            entry.name = name;
+            entry.plugin = section.GetValue("Plugin"sv);
+            entry.localFormID = Text::ParseNumber<std::uint32_t>(section.GetValue("FormID"sv), 16).value_or(0);
+            entry.enabled = section.GetBool("Enabled"sv, true);
+            entry.className = section.GetValue("Class"sv);
+
+            if (entry.plugin.empty() || entry.localFormID == 0) {
+                logger::warn("Section [{}] is missing FormID or Plugin, skipping", sectionName);
+                continue;
             }
-        }
-    }
-    
-    void HandleWeaponUnequipped(RE::Actor* actor, RE::TESObjectWEAP* weapon) {
-        auto settings = Settings::GetSingleton();
-        auto weaponID = weapon->GetFormID();
-        auto actorID = actor->GetFormID();
-        
-        auto it = actorStates.find(actorID);
-        if (it == actorStates.end()) {
-            return;
-        }
-        
-        auto& state = it->second;
-        
-        // Check weapon type
-        if (weapon->GetWeaponType() == RE::WEAPON_TYPE::kBow) {
-            // Remove bow bonuses
-            RemoveBowBonus(actor);
-            
-            // Check if it's the special bow
-            if (settings->IsSpecialBow(weaponID)) {
-                RemoveSpecialBowBonus(actor);
+
+            if (kind == "Follower"sv) {
+                snapshot.followers.push_back(std::move(entry));
+            } else if (kind == "SpecialBow"sv) {
+                snapshot.specialBows.push_back(std::move(entry));
+            } else if (kind == "SpecialSword"sv) {
+                snapshot.specialSwords.push_back(std::move(entry));
             }
-            
-            state.equippedBowID = 0;
-        } else if (settings->IsSpecialSword(weaponID)) {
-            // It's the special sword, stop the knockback effect
-            StopSwordKnockback(actor);
-            state.equippedSwordID = 0;
         }
+
+        return snapshot;
     }
-    
-    void ApplyAccuracyImprovements(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        // If already applied, return
-        if (it != actorStates.end() && it->second.improvementsApplied) {
-            return;
-        }
-        
-        // Get settings
-        auto settings = Settings::GetSingleton();
-        
-        // Create state for this actor if it doesn't exist
-        auto& state = actorStates[actorID];
-        
-        // Store original values
-        state.originalMarksman = actor->GetActorValueByName("Marksman");
-        state.originalAttackAngleMult = actor->GetActorValueByName("attackAngleMult");
-        state.originalAimOffsetV = actor->GetActorValueByName("aimOffsetV");
-        state.originalAimSightedDelay = actor->GetActorValueByName("aimSightedDelay");
-        state.originalCombatHealthRegenMult = actor->GetActorValueByName("combatHealthRegenMult");
-        
-        // Apply improvements
-        if (actor->GetActorValueByName("Marksman") < state.originalMarksman + settings->GetBaseAccuracyBonus()) {
-            actor->SetActorValueByName("Marksman", state.originalMarksman + settings->GetBaseAccuracyBonus());
-        }
-        
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult());
-        actor->SetActorValueByName("aimOffsetV", settings->GetAimOffsetV());
-        actor->SetActorValueByName("aimSightedDelay", settings->GetAimSightedDelay());
-        actor->SetActorValueByName("combatHealthRegenMult", 2.0f);
-        
-        state.improvementsApplied = true;
-        
-        // Notify player if the follower is player's follower
-        if (actor->IsPlayerTeammate()) {
-            RE::DebugNotification(fmt::format("{}'s Accuracy Improvements Applied", actor->GetName()).c_str());
+
+    // Every key in a [Class:Name] section is an actor value modifier, except the weapon condition
+    static CombatClasses::RawClass ParseClass(const Text::IniDocument::Section& section, std::string_view name) {
+        CombatClasses::RawClass rawClass;
+        rawClass.name = name;
+
+        for (const auto& [key, value] : section.entries) {
+            if (Text::IEquals(key, "Weapon"sv)) {
+                if (auto condition = CombatClasses::ParseWeaponCondition(value)) {
+                    rawClass.condition = *condition;
+                } else {
+                    logger::warn("Class {}: unknown weapon condition '{}'", name, value);
+                }
+                continue;
+            }
+
+            if (auto modifier = CombatClasses::ParseModifier(key, value)) {
+                rawClass.modifiers.push_back(std::move(*modifier));
+            } else {
+                logger::warn("Class {}: invalid modifier {}={}", name, key, value);
+            }
         }
-        
-        logger::info("Applied accuracy improvements to {}", actor->GetName());
+
+        return rawClass;
     }
-    
-    void RemoveAccuracyImprovements(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        // If not applied, return
-        if (it == actorStates.end() || !it->second.improvementsApplied) {
-            return;
+
+    // A [Rule:Name] section assigns Class to every NPC that passes all of its predicates
+    static std::optional<CombatClasses::RawRule> ParseRule(const Text::IniDocument::Section& section, std::string_view name) {
+        CombatClasses::RawRule rule;
+        rule.name = name;
+        rule.className = section.GetValue("Class"sv);
+        if (rule.className.empty()) {
+            logger::warn("Rule {} has no Class, skipping", name);
+            return std::nullopt;
         }
-        
-        auto& state = it->second;
-        
-        // Restore original values
-        actor->SetActorValueByName("Marksman", state.originalMarksman);
-        actor->SetActorValueByName("attackAngleMult", state.originalAttackAngleMult);
-        actor->SetActorValueByName("aimOffsetV", state.originalAimOffsetV);
-        actor->SetActorValueByName("aimSightedDelay", state.originalAimSightedDelay);
-        actor->SetActorValueByName("combatHealthRegenMult", state.originalCombatHealthRegenMult);
-        
-        state.improvementsApplied = false;
-        
-        logger::info("Removed accuracy improvements from {}", actor->GetName());
-    }
-    
-    void ApplyBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", settings->GetBowAccuracyBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.8f);
-        
-        logger::info("Applied bow bonus to {}", actor->GetName());
-    }
-    
-    void RemoveBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", -settings->GetBowAccuracyBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult());
-        
-        logger::info("Removed bow bonus from {}", actor->GetName());
-    }
-    
-    void ApplySpecialBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        // If already applied, return
-        if (it != actorStates.end() && it->second.hasSpecialBowBonus) {
-            return;
+
+        rule.factions = CombatClasses::SplitList(section.GetValue("Faction"sv));
+        rule.races = CombatClasses::SplitList(section.GetValue("Race"sv));
+        rule.keywords = CombatClasses::SplitList(section.GetValue("Keyword"sv));
+        rule.minLevel = section.GetNumber<std::uint16_t>("MinLevel"sv, 0);
+        rule.maxLevel = section.GetNumber<std::uint16_t>("MaxLevel"sv, 0);
+
+        if (auto weapon = section.Find("Weapon"sv)) {
+            rule.weapon = CombatClasses::ParseWeaponCondition(*weapon);
+            if (!rule.weapon) {
+                logger::warn("Rule {}: unknown weapon condition '{}', skipping", name, *weapon);
+                return std::nullopt;
+            }
         }
-        
-        auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", settings->GetSpecialBowBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.6f);
-        
-        // Update state
-        auto& state = actorStates[actorID];
-        state.hasSpecialBowBonus = true;
-        
-        logger::info("Applied special bow bonus to {}", actor->GetName());
+
+        return rule;
     }
-    
-    void RemoveSpecialBowBonus(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        // If not applied, return
-        if (it == actorStates.end() || !it->second.hasSpecialBowBonus) {
-            return;
+
+    // A [WeaponProfile:Name] section applies to every weapon carrying one of its keywords or enchantments
+    static CombatClasses::RawWeaponProfile ParseWeaponProfile(const Text::IniDocument::Section& section, std::string_view name) {
+        CombatClasses::RawWeaponProfile profile;
+        profile.name = name;
+        profile.keywords = CombatClasses::SplitList(section.GetValue("Keyword"sv));
+        profile.enchantments = CombatClasses::SplitList(section.GetValue("Enchantment"sv));
+        profile.accuracy = section.GetNumber<float>("Accuracy"sv, profile.accuracy);
+        profile.knockback = section.GetNumber<float>("Knockback"sv, profile.knockback);
+        profile.stagger = section.GetNumber<float>("Stagger"sv, profile.stagger);
+        profile.procChance = section.GetNumber<float>("ProcChance"sv, profile.procChance);
+
+        if (profile.keywords.empty() && profile.enchantments.empty()) {
+            logger::warn("Weapon profile {} has no Keyword or Enchantment and will never apply", name);
         }
-        
-        auto settings = Settings::GetSingleton();
-        actor->ModActorValueByName("Marksman", -settings->GetSpecialBowBonus());
-        actor->SetActorValueByName("attackAngleMult", settings->GetAttackAngleMult() * 0.8f);
-        
-        // Update state
-        it->second.hasSpecialBowBonus = false;
-        
-        logger::info("Removed special bow bonus from {}", actor->GetName());
+        return profile;
     }
-    
-    void StartSwordKnockback(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto& state = actorStates[actorID];
-        
-        // If already active, return
-        if (state.swordKnockbackActive) {
+
+    // Resolves the snapshot's forms against the current load order and makes it live. Game thread only.
+    void Apply(Snapshot&& snapshot) {
+        StartupProfile::ScopedPhase timer(StartupProfile::Phase::kFormResolution);
+        config = std::move(snapshot);
+        ++appliedGeneration;
+
+        followers.clear();
+        enabledFollowers.clear();
+        followerIDs.clear();
+        specialBows.clear();
+        specialSwords.clear();
+        followerClasses.clear();
+
+        classTable.Compile(config.classes);
+        ruleTable.Compile(config.rules, classTable);
+        CombatClasses::ThreatMap::GetSingleton()->SetHalfLife(config.threatHalfLife);
+
+        // Weapons are matched in the background; derived caches rebuild once the table lands
+        weaponProfiles.Compile(config.weaponProfiles, [this]() {
+            ++appliedGeneration;
+            RebuildStrikeWeaponFilter();
+        });
+
+        auto dataHandler = RE::TESDataHandler::GetSingleton();
+        if (!dataHandler) {
+            logger::error("Failed to get data handler, no forms resolved");
             return;
         }
-        
-        state.swordKnockbackActive = true;
-        state.lastKnockbackTime = std::chrono::steady_clock::now();
-        
-        logger::info("Started sword knockback for {}", actor->GetName());
-    }
-    
-    void StopSwordKnockback(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto actorID = actor->GetFormID();
-        auto it = actorStates.find(actorID);
-        
-        if (it != actorStates.end()) {
-            it->second.swordKnockbackActive = false;
-            logger::info("Stopped sword knockback for {}", actor->GetName());
-        }
-    }
-    
-    void HandleSwordKnockback(RE::Actor* actor) {
-        if (!actor) return;
-        
-        auto settings = Settings::GetSingleton();
-        
-        // Find nearest enemy
-        auto nearestEnemy = GetNearestEnemy(actor);
-        if (nearestEnemy && !nearestEnemy->IsDead() && nearestEnemy->IsHostileToActor(actor)) {
-            // Apply knockback effect - using Skyrim's native PushActorAway function
-            // We need to access it through the game's script system
-            RE::TESForm* gameObj = RE::TESForm::LookupByID(0x14);  // Game's formID
-            if (gameObj) {
-                auto vm = SKSE::GetPapyrusInterface()->GetVirtualMachine();
-                if (vm) {
-                    // Create argument list
-                    RE::TESObjectREFR* source = actor;
-                    RE::TESObjectREFR* target = nearestEnemy;
-                    float magnitude = settings->GetKnockbackMagnitude();
-                    
-                    RE::BSFixedString funcName("PushActorAway");
-                    RE::BSFixedString objName("Game");
-                    
-                    // Call the function
-                    std::vector<RE::BSScript::Variable> args;
-                    
-                    RE::BSScript::Variable targetVar;
-                    targetVar.SetObject(target);
-                    args.push_back(targetVar);
-                    
-                    RE::BSScript::Variable sourceVar;
-                    sourceVar.SetObject(source);
-                    args.push_back(sourceVar);
-                    
-                    RE::BSScript::Variable magVar;
-                    magVar.SetFloat(magnitude);
-                    args.push_back(magVar);
-                    
-                    auto nullHandle = RE::BSScript::IObjectHandlePolicy::InvalidHandle;
-                    
-                    vm->SendEvent(nullHandle, objName.c_str(), funcName.c_str(), args);
-                }
+
+        auto resolve = [&](const FormEntry& entry) -> RE::FormID {
+            auto formID = dataHandler->LookupFormID(entry.localFormID, entry.plugin);
+            if (!formID) {
+                logger::warn("Could not resolve {} ({:X} in {})", entry.name, entry.localFormID, entry.plugin);
             }
-            
-            // Notify player if the follower is player's teammate
-            if (actor->IsPlayerTeammate()) {
-                auto weapon = actor->GetEquippedObject(false);
-                if (weapon) {
-                    auto name = weapon->GetName();
-                    RE::DebugNotification(fmt::format("{} unleashes a powerful knockback!", name).c_str());
+            return formID;
+        };
+
+        for (const auto& entry : config.followers) {
+            if (auto formID = resolve(entry)) {
+                followers[entry.name] = formID;
+                followerIDs.insert(formID);
+                if (entry.enabled) {
+                    enabledFollowers.insert(formID);
+                }
+                if (!entry.className.empty()) {
+                    auto classID = classTable.Find(entry.className);
+                    if (classID == CombatClasses::kNoClass) {
+                        logger::warn("Follower {} uses unknown class {}", entry.name, entry.className);
+                    } else {
+                        followerClasses[formID] = classID;
+                    }
                 }
             }
-            
-            logger::info("{} performed knockback on {}", actor->GetName(), nearestEnemy->GetName());
         }
-    }
-    
-    RE::Actor* GetNearestEnemy(RE::Actor* actor) {
-        if (!actor) return nullptr;
-        
-        std::vector<RE::Actor*> combatTargets;
-        
-        // Add player's combat target if relevant
-        auto player = RE::PlayerCharacter::GetSingleton();
-        if (player) {
-            auto target = player->GetActorRuntimeData().currentCombatTarget.get();
-            if (target && !target->IsDead() && target->IsHostileToActor(actor)) {
-                combatTargets.push_back(target.get());
+        for (const auto& entry : config.specialBows) {
+            if (auto formID = resolve(entry)) {
+                specialBows.insert(formID);
             }
         }
-        
-        // Add actor's combat target
-        auto targetPtr = actor->GetActorRuntimeData().currentCombatTarget.get();
-        if (targetPtr && !targetPtr->IsDead()) {
-            // Check if already in the list
-            bool found = false;
-            for (auto target : combatTargets) {
-                if (target == targetPtr.get()) {
-                    found = true;
-                    break;
-                }
-            }
-            
-            if (!found) {
-                combatTargets.push_back(targetPtr.get());
+        for (const auto& entry : config.specialSwords) {
+            if (auto formID = resolve(entry)) {
+                specialSwords.insert(formID);
             }
         }
-        
-        // Find nearest from the targets
-        RE::Actor* nearestActor = nullptr;
-        float nearestDistance = 99999.0f;
-        
-        for (auto target : combatTargets) {
-            if (target) {
-                float currentDistance = actor->GetPosition().GetDistance(target->GetPosition());
-                if (currentDistance < nearestDistance) {
-                    nearestDistance = currentDistance;
-                    nearestActor = target;
-                }
-            }
+
+        logger::info("Settings loaded: {} followers, {} special bows, {} special swords",
+            followers.size(), specialBows.size(), specialSwords.size());
+
+        RebuildStrikeWeaponFilter();
+
+        Telemetry::Registry::GetSingleton()->Configure(config.telemetryInterval, config.telemetryFormat);
+    }
+
+    void RebuildStrikeWeaponFilter() {
+        strikeWeaponFilter.Clear();
+        for (auto formID : specialSwords) {
+            strikeWeaponFilter.Insert(formID);
         }
-        
-        return nearestActor;
+        weaponProfiles.ForEachWeapon([this](RE::FormID weaponID, const CombatClasses::WeaponProfile& profile) {
+            if (profile.HasStrikeEffect()) {
+                strikeWeaponFilter.Insert(weaponID);
+            }
+        });
     }
-};
\ No newline at end of file
+
+    void LoadSettings() {
+        ++loadGeneration;
+        Apply(Parse(settingsPath));
+    }
+
+    // Parses the file on a worker and applies it on the game thread, then runs onLoaded there
+    void LoadSettingsAsync(std::function<void()> onLoaded = nullptr) {
+        auto generation = ++loadGeneration;
+        ThreadPool::GetSingleton()->Submit(
+            [] { return Parse(settingsPath); },
+            [this, generation, onLoaded = std::move(onLoaded)](Snapshot&& snapshot) {
+                if (generation != loadGeneration) {
+                    return;
+                }
+                Apply(std::move(snapshot));
+                if (onLoaded) {
+                    onLoaded();
+                }
+            });
+    }
+
+    const std::unordered_map<std::string, RE::FormID>& GetFollowers() const { return followers; }
+
+    // Whether anything in the config or registered at runtime can make the plugin act on an actor
+    bool HasTrackedForms() const { return !followerIDs.empty() || !runtimeFollowers.empty() || !ruleTable.empty(); }
+
+    bool IsFollower(RE::FormID formID) const { return followerIDs.contains(formID) || runtimeFollowers.contains(formID); }
+    bool IsFollowerEnabled(RE::FormID formID) const { return enabledFollowers.contains(formID) || runtimeFollowers.contains(formID); }
+
+    const CombatClasses::ClassTable& GetClassTable() const { return classTable; }
+    const CombatClasses::RuleTable& GetRuleTable() const { return ruleTable; }
+    const CombatClasses::WeaponProfileTable& GetWeaponProfiles() const { return weaponProfiles; }
+    std::uint32_t GetAppliedGeneration() const { return appliedGeneration; }
+
+    CombatClasses::ClassID GetFollowerClass(RE::FormID formID) const {
+        auto it = followerClasses.find(formID);
+        return it != followerClasses.end() ? it->second : CombatClasses::kNoClass;
+    }
+
+    bool AddRuntimeFollower(RE::FormID formID) { return runtimeFollowers.insert(formID).second; }
+    bool RemoveRuntimeFollower(RE::FormID formID) { return runtimeFollowers.erase(formID) > 0; }
+    std::unordered_set<RE::FormID> TakeRuntimeFollowers() { return std::exchange(runtimeFollowers, {}); }
+    bool IsSpecialBow(RE::FormID formID) const { return specialBows.contains(formID); }
+    bool IsSpecialSword(RE::FormID formID) const { return specialSwords.contains(formID); }
+    // False positives are possible, false negatives are not
+    bool MayBeStrikeWeapon(RE::FormID formID) const { return strikeWeaponFilter.MayContain(formID); }
+
+    float GetBaseAccuracyBonus() const { return config.baseAccuracyBonus; }
+    float GetAttackAngleMult() const { return config.attackAngleMult; }
+    float GetAimOffsetV() const { return config.aimOffsetV; }
+    float GetAimSightedDelay() const { return config.aimSightedDelay; }
+    bool GetAutoApplyImprovements() const { return config.autoApplyImprovements; }
+    float GetBowAccuracyBonus() const { return config.bowAccuracyBonus; }
+    float GetSpecialBowBonus() const { return config.specialBowBonus; }
+    float GetBowAttackAngleScale() const { return config.bowAttackAngleScale; }
+    float GetSpecialBowAttackAngleScale() const { return config.specialBowAttackAngleScale; }
+    float GetCombatHealthRegenMult() const { return config.combatHealthRegenMult; }
+    float GetKnockbackMagnitude() const { return config.knockbackMagnitude; }
+    float GetKnockbackInterval() const { return config.knockbackInterval; }
+    float GetKnockbackRadius() const { return config.knockbackRadius; }
+    float GetKnockbackConeAngle() const { return config.knockbackConeAngle; }
+    std::uint32_t GetKnockbackMaxTargets() const { return config.knockbackMaxTargets; }
+    std::uint32_t GetMaxPushesPerFrame() const { return config.maxPushesPerFrame; }
+    float GetIdleCooldown() const { return config.idleCooldown; }
+    bool GetCoordinateTargets() const { return config.coordinateTargets; }
+    float GetTargetSearchRadius() const { return config.targetSearchRadius; }
+    std::uint32_t GetTargetBudgetMicros() const { return config.targetBudgetMicros; }
+    float GetLineOfSightTTL() const { return config.lineOfSightTTL; }
+    std::uint32_t GetMaxRaycastsPerFrame() const { return config.maxRaycastsPerFrame; }
+    bool GetStrikeOnHit() const { return config.strikeOnHit; }
+};
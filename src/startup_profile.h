@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+// Wall time of each startup phase, logged so the plugin's share of game boot time can be tracked
+namespace StartupProfile {
+    enum class Phase : std::uint8_t {
+        kLogSetup,
+        kSettingsParse,
+        kFormResolution,
+        kSinkRegistration,
+        kPhaseCount
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(Phase::kPhaseCount)> phaseNames{
+        "log setup"sv, "settings parse"sv, "form resolution"sv, "sink registration"sv
+    };
+
+    // Latest duration of each phase in microseconds. Parsing runs on a worker, hence atomics.
+    inline std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(Phase::kPhaseCount)> durations{};
+
+    class ScopedPhase {
+    private:
+        Phase phase;
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    public:
+        explicit ScopedPhase(Phase a_phase) : phase(a_phase) {}
+
+        ScopedPhase(const ScopedPhase&) = delete;
+        ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+        ~ScopedPhase() {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+            durations[static_cast<std::size_t>(phase)].store(elapsed, std::memory_order_relaxed);
+            logger::debug("Startup phase {} took {}us", phaseNames[static_cast<std::size_t>(phase)], elapsed);
+        }
+    };
+
+    inline void Report() {
+        std::int64_t total = 0;
+        for (std::size_t i = 0; i < durations.size(); ++i) {
+            auto elapsed = durations[i].load(std::memory_order_relaxed);
+            total += elapsed;
+            logger::info("  {:<18} {:>8}us", phaseNames[i], elapsed);
+        }
+        logger::info("Startup total: {}us", total);
+    }
+}
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <span>
+#include "assignment.h"
+#include "fixed_containers.h"
+#include "hostility_cache.h"
+#include "los_cache.h"
+#include "threat_map.h"
+#include "settings.h"
+
+// Spreads the party over the enemies instead of letting every follower pick the same nearest one.
+// Runs once per tick over all fighting followers and nearby hostiles. Costs are cached per
+// (follower, enemy) pair and only recomputed for actors whose position, weapon, target or top threat
+// changed, and the assignment is only solved again when a cost moved.
+namespace CombatClasses {
+    class TargetAllocator {
+    public:
+        static constexpr std::size_t maxFollowers = 16;
+        static constexpr std::size_t maxEnemies = 64;
+
+    private:
+        static inline TargetAllocator* instance = nullptr;
+
+        static constexpr std::uint8_t unassigned = kUnassigned;
+
+        // Movement below this doesn't change anyone's choice enough to be worth recomputing
+        static constexpr float moveThresholdSquared = 64.0f * 64.0f;
+
+        // Cost terms, in game units of distance
+        static constexpr float rangedDistanceScale = 0.25f;  // archers and casters care little about distance
+        static constexpr float attackingMemberBonus = 512.0f;  // the enemy is hitting this follower
+        static constexpr float attackingPlayerBonus = 256.0f;  // the enemy is hitting the player
+        static constexpr float crowdingPenalty = 768.0f;       // per follower already on the enemy
+        static constexpr float occludedPenalty = 2048.0f;      // a ranged follower can't see the enemy
+        static constexpr float topThreatBonus = 1024.0f;       // the enemy that has hurt this follower most
+
+        // Decayed threat below which nobody counts as a follower's top threat, about half a hit
+        static constexpr float minTopThreat = 0.5f;
+
+        struct Member {
+            RE::FormID formID = 0;
+            RE::ActorHandle handle;
+            RE::NiPoint3 position;
+            bool ranged = false;
+            bool dirty = true;
+            bool fresh = true;  // no cached costs yet
+            RE::FormID topThreat = 0;
+            std::uint8_t assigned = unassigned;
+            RE::ActorHandle target;
+        };
+
+        struct Enemy {
+            RE::FormID formID = 0;
+            RE::ActorHandle handle;
+            RE::NiPoint3 position;
+            RE::FormID targetID = 0;
+            // Bit i is set when the enemy is hostile to member i; the others can't be assigned to it
+            std::uint16_t hostileTo = 0;
+            bool dirty = true;
+            bool fresh = true;
+        };
+
+        static_assert(maxFollowers <= 16, "Enemy::hostileTo has one bit per follower");
+
+        FixedVector<Member, maxFollowers> members;
+        FixedVector<Enemy, maxEnemies> enemies;
+        std::array<std::array<float, maxEnemies>, maxFollowers> costs{};
+        HostilityCache<maxFollowers> hostility;
+        RE::FormID playerID = 0;
+
+        // Line of sight results the ranged rows were computed with
+        std::uint32_t losVersion = 0;
+
+        // Whether the last solve was interrupted by the budget, so the next tick picks it up
+        bool carryOver = false;
+
+        std::uint64_t solves = 0;
+        std::uint64_t skippedSolves = 0;
+        std::uint64_t recomputedCosts = 0;
+        std::uint64_t budgetOverruns = 0;
+
+        TargetAllocator() = default;
+
+    public:
+        static TargetAllocator* GetSingleton() {
+            if (!instance) {
+                instance = new TargetAllocator();
+            }
+            return instance;
+        }
+
+        // Refreshes inputs and reassigns where something changed. Game thread, once per tick.
+        void Update(std::span<RE::Actor* const> followers) {
+            auto settings = Settings::GetSingleton();
+            if (!settings->GetCoordinateTargets() || followers.empty()) {
+                Clear();
+                return;
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            auto budget = std::chrono::microseconds(settings->GetTargetBudgetMicros());
+
+            bool changed = RefreshMembers(followers);
+            changed |= RefreshEnemies();
+
+            // Someone's view opened up or got blocked, so ranged rows are redone
+            if (auto version = LineOfSightCache::GetSingleton()->GetVersion(); version != losVersion) {
+                losVersion = version;
+                for (auto& member : members) {
+                    if (member.ranged) {
+                        member.dirty = true;
+                        changed = true;
+                    }
+                }
+            }
+
+            if (!changed && !carryOver) {
+                ++skippedSolves;
+                return;
+            }
+
+            // Only pairs with a dirty side are recomputed. Past the budget, pairs that have a cached cost
+            // keep it until the next tick; pairs without one are always computed.
+            carryOver = false;
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                auto& member = members[i];
+                for (std::size_t j = 0; j < enemies.size(); ++j) {
+                    const auto& enemy = enemies[j];
+                    if (!member.dirty && !enemy.dirty) {
+                        continue;
+                    }
+                    if (carryOver && !member.fresh && !enemy.fresh) {
+                        continue;
+                    }
+                    costs[i][j] = (enemy.hostileTo >> i) & 1 ? Cost(member, enemy) : kForbiddenCost;
+                    ++recomputedCosts;
+                }
+                if (!carryOver) {
+                    member.dirty = false;
+                }
+                member.fresh = false;
+
+                if (!carryOver && i + 1 < members.size() && std::chrono::steady_clock::now() - started > budget) {
+                    carryOver = true;
+                    ++budgetOverruns;
+                }
+            }
+            for (auto& enemy : enemies) {
+                enemy.fresh = false;
+                if (!carryOver) {
+                    enemy.dirty = false;
+                }
+            }
+
+            Solve();
+            ++solves;
+        }
+
+        // Enemy the follower should focus, or null if it has no assignment or the enemy is gone
+        RE::NiPointer<RE::Actor> GetTarget(RE::FormID formID) const {
+            auto it = std::ranges::find(members, formID, &Member::formID);
+            if (it == members.end()) {
+                return nullptr;
+            }
+            auto target = it->target.get();
+            return target && !target->IsDead() ? target : nullptr;
+        }
+
+        void Clear() {
+            if (members.empty() && enemies.empty()) {
+                return;
+            }
+            members.clear();
+            enemies.clear();
+            hostility.Clear();
+            carryOver = false;
+            logger::debug("Target allocation: {} solves, {} skipped, {} costs recomputed, {} budget overruns, {} hostility checks, {} reused",
+                solves, skippedSolves, recomputedCosts, budgetOverruns, hostility.GetChecks(), hostility.GetHits());
+        }
+
+    private:
+        // Rebuilds the member list in the followers' order, keeping cached rows of followers that barely moved
+        bool RefreshMembers(std::span<RE::Actor* const> followers) {
+            bool changed = followers.size() != members.size();
+
+            FixedVector<Member, maxFollowers> refreshed;
+            std::array<std::array<float, maxEnemies>, maxFollowers> refreshedCosts;
+
+            for (auto actor : followers) {
+                Member member;
+                member.formID = actor->GetFormID();
+                member.handle = actor->GetHandle();
+                member.position = actor->GetPosition();
+                member.ranged = IsRanged(actor);
+                member.topThreat = ThreatMap::GetSingleton()->GetTopThreat(member.formID, minTopThreat);
+
+                auto previous = std::ranges::find(members, member.formID, &Member::formID);
+                if (previous != members.end()) {
+                    auto index = static_cast<std::size_t>(previous - members.begin());
+                    // Enemies' hostility bits follow the member order, so a member that moved is redone
+                    auto reordered = index != refreshed.size();
+                    refreshedCosts[refreshed.size()] = costs[index];
+                    member.assigned = previous->assigned;
+                    member.target = previous->target;
+                    member.fresh = previous->fresh;
+
+                    bool moved = previous->position.GetSquaredDistance(member.position) > moveThresholdSquared;
+                    member.dirty = previous->dirty || moved || reordered || previous->ranged != member.ranged ||
+                                   previous->topThreat != member.topThreat;
+                    if (!member.dirty) {
+                        // Keep the position the row was computed at, so slow drift still adds up
+                        member.position = previous->position;
+                    }
+                }
+                changed |= member.dirty;
+
+                if (!refreshed.push_back(member)) {
+                    break;
+                }
+            }
+
+            members = refreshed;
+            costs = refreshedCosts;
+            return changed;
+        }
+
+        // Collects actors around the player hostile to at least one member, keeping cached columns of
+        // enemies that barely moved
+        bool RefreshEnemies() {
+            auto processLists = RE::ProcessLists::GetSingleton();
+            auto player = RE::PlayerCharacter::GetSingleton();
+            if (!processLists || !player) {
+                bool changed = !enemies.empty();
+                enemies.clear();
+                return changed;
+            }
+
+            auto radius = Settings::GetSingleton()->GetTargetSearchRadius();
+            auto radiusSquared = radius * radius;
+            auto origin = player->GetPosition();
+            playerID = player->GetFormID();
+
+            // Members are resolved once for the whole scan rather than once per candidate
+            std::array<RE::FormID, maxFollowers> memberIDs;
+            std::array<RE::NiPointer<RE::Actor>, maxFollowers> memberActors;
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                memberIDs[i] = members[i].formID;
+                memberActors[i] = members[i].handle.get();
+            }
+            hostility.BeginRefresh(std::span(memberIDs.data(), members.size()));
+
+            FixedVector<Enemy, maxEnemies> refreshed;
+            std::array<std::uint8_t, maxEnemies> previousIndex;
+            bool changed = false;
+
+            for (auto& handle : processLists->highActorHandles) {
+                if (refreshed.full()) {
+                    break;
+                }
+                auto candidate = handle.get();
+                if (!candidate || candidate->IsDead() || !candidate->IsInCombat()) {
+                    continue;
+                }
+                auto position = candidate->GetPosition();
+                if (origin.GetSquaredDistance(position) > radiusSquared) {
+                    continue;
+                }
+
+                auto formID = candidate->GetFormID();
+                auto target = candidate->GetActorRuntimeData().currentCombatTarget.get();
+                auto targetID = target ? target->GetFormID() : 0;
+
+                // Followers can be on different sides of a fight, e.g. one of them is in a faction the enemy spares
+                auto hostileTo = hostility.Get(formID, targetID, [&](std::size_t i) {
+                    return memberActors[i] && candidate->IsHostileToActor(memberActors[i].get());
+                });
+                if (!hostileTo) {
+                    continue;
+                }
+
+                Enemy enemy;
+                enemy.formID = formID;
+                enemy.handle = handle;
+                enemy.position = position;
+                enemy.targetID = targetID;
+                enemy.hostileTo = hostileTo;
+
+                auto index = unassigned;
+                auto previous = std::ranges::find(enemies, enemy.formID, &Enemy::formID);
+                if (previous != enemies.end()) {
+                    index = static_cast<std::uint8_t>(previous - enemies.begin());
+                    bool moved = previous->position.GetSquaredDistance(position) > moveThresholdSquared;
+                    enemy.dirty = previous->dirty || moved || previous->targetID != enemy.targetID || previous->hostileTo != enemy.hostileTo;
+                    enemy.fresh = previous->fresh;
+                    if (!enemy.dirty) {
+                        enemy.position = previous->position;
+                    }
+                }
+                changed |= enemy.dirty;
+
+                previousIndex[refreshed.size()] = index;
+                refreshed.push_back(enemy);
+            }
+            hostility.EndRefresh();
+            changed |= refreshed.size() != enemies.size();
+
+            // Move cached columns to the enemies' new places; new enemies are dirty and get computed
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                std::array<float, maxEnemies> row{};
+                for (std::size_t j = 0; j < refreshed.size(); ++j) {
+                    if (previousIndex[j] != unassigned) {
+                        row[j] = costs[i][previousIndex[j]];
+                    }
+                }
+                costs[i] = row;
+
+                auto assigned = members[i].assigned;
+                members[i].assigned = unassigned;
+                if (assigned != unassigned) {
+                    for (std::size_t j = 0; j < refreshed.size(); ++j) {
+                        if (previousIndex[j] == assigned) {
+                            members[i].assigned = static_cast<std::uint8_t>(j);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            enemies = refreshed;
+            return changed;
+        }
+
+        float Cost(const Member& member, const Enemy& enemy) const {
+            auto cost = member.position.GetDistance(enemy.position);
+            if (member.ranged) {
+                cost *= rangedDistanceScale;
+
+                // Unknown visibility counts as clear until the check comes back
+                auto shooter = member.handle.get();
+                auto target = enemy.handle.get();
+                if (shooter && target) {
+                    if (auto visible = LineOfSightCache::GetSingleton()->Query(shooter.get(), target.get()); visible && !*visible) {
+                        cost += occludedPenalty;
+                    }
+                }
+            }
+            if (enemy.formID == member.topThreat) {
+                cost -= topThreatBonus;
+            }
+            if (enemy.targetID == member.formID) {
+                cost -= attackingMemberBonus;
+            } else if (enemy.targetID == playerID) {
+                cost -= attackingPlayerBonus;
+            }
+            return cost;
+        }
+
+        // Followers keep their enemy on ties; one no enemy is hostile to is left without a target
+        void Solve() {
+            std::array<std::uint8_t, maxFollowers> assigned;
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                assigned[i] = members[i].assigned;
+            }
+            AssignGreedy(costs, enemies.size(), crowdingPenalty, std::span(assigned.data(), members.size()));
+
+            for (std::size_t i = 0; i < members.size(); ++i) {
+                members[i].assigned = assigned[i];
+                if (assigned[i] != unassigned) {
+                    members[i].target = enemies[assigned[i]].handle;
+                } else {
+                    members[i].target.reset();
+                }
+            }
+        }
+
+        static bool IsRanged(RE::Actor* actor) {
+            auto equipped = actor->GetEquippedObject(false);
+            if (!equipped) {
+                return false;
+            }
+            if (auto weapon = equipped->As<RE::TESObjectWEAP>()) {
+                return weapon->IsBow() || weapon->IsCrossbow() || weapon->IsStaff();
+            }
+            // A spell in hand
+            return equipped->Is(RE::FormType::Spell);
+        }
+    };
+}
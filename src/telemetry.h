@@ -0,0 +1,274 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "thread_pool.h"
+
+// How often follower bonuses actually come into play. Counters live in fixed tables of relaxed atomics,
+// so any thread can bump them without locking or allocating, and a background thread snapshots them
+// to the SKSE log folder every iTelemetryInterval seconds. Nothing is counted while export is off. The
+// game thread never waits on the exporter: switching export off only signals it, and a worker joins it.
+namespace Telemetry {
+    enum class Counter : std::uint8_t {
+        kArrowsFired,
+        kHits,
+        kKnockbacks,
+        kStaggers,
+        kBonusesApplied,
+        kBonusesRemoved,
+        kCount
+    };
+
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(Counter::kCount)> counterNames{
+        "arrows_fired"sv, "hits"sv, "knockbacks"sv, "staggers"sv, "bonuses_applied"sv, "bonuses_removed"sv
+    };
+
+    enum class Format : std::uint8_t {
+        kJSON,
+        kCSV
+    };
+
+    class Registry {
+    private:
+        static inline Registry* instance = nullptr;
+
+        struct Slot {
+            // 0 while free; claimed once with a compare-exchange and never released
+            std::atomic<RE::FormID> key{ 0 };
+            std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::kCount)> values{};
+        };
+
+        // Open addressed by FormID. Once a table is full new keys are counted as overflow only.
+        template <std::size_t N>
+        struct Table {
+            static_assert(std::has_single_bit(N));
+
+            std::array<Slot, N> slots;
+            std::atomic<std::uint64_t> overflow{ 0 };
+
+            Slot* Find(RE::FormID key) {
+                auto start = (key * 0x9E3779B1u) & (N - 1);
+                for (std::size_t probe = 0; probe < N; ++probe) {
+                    auto& slot = slots[(start + probe) & (N - 1)];
+                    auto current = slot.key.load(std::memory_order_acquire);
+                    if (current == key) {
+                        return &slot;
+                    }
+                    if (current == 0 && slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                        return &slot;
+                    }
+                    // Lost the race for this slot; it may have gone to the same key
+                    if (current == key) {
+                        return &slot;
+                    }
+                }
+                overflow.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        };
+
+        Table<64> actors;
+        Table<256> weapons;
+
+        // Export settings, read by the exporter on every cycle
+        std::atomic<std::uint32_t> intervalSeconds{ 0 };
+        std::atomic<Format> format{ Format::kJSON };
+
+        // Runs while the interval is non-zero. Game thread only starts and stops it.
+        std::jthread exporter;
+        std::mutex exporterLock;
+        std::condition_variable_any exporterWake;
+
+        // A stopped exporter may still be finishing a file when a new one starts
+        std::mutex exportLock;
+
+        Registry() = default;
+
+    public:
+        static Registry* GetSingleton() {
+            if (!instance) {
+                instance = new Registry();
+            }
+            return instance;
+        }
+
+        // Counters only run while export is on, so callers on hot paths can skip gathering their inputs
+        bool IsCounting() const { return intervalSeconds.load(std::memory_order_relaxed) > 0; }
+
+        // Safe from any thread. Either FormID may be 0 to skip that table.
+        void Add(Counter counter, RE::FormID actor, RE::FormID weapon = 0, std::uint64_t amount = 1) {
+            if (!IsCounting()) {
+                return;
+            }
+            auto index = static_cast<std::size_t>(counter);
+            if (actor) {
+                if (auto slot = actors.Find(actor)) {
+                    slot->values[index].fetch_add(amount, std::memory_order_relaxed);
+                }
+            }
+            if (weapon) {
+                if (auto slot = weapons.Find(weapon)) {
+                    slot->values[index].fetch_add(amount, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Applies the export settings, starting the exporter when export turns on and stopping it when it
+        // turns off. Game thread.
+        void Configure(std::uint32_t a_intervalSeconds, Format a_format) {
+            intervalSeconds.store(a_intervalSeconds, std::memory_order_relaxed);
+            format.store(a_format, std::memory_order_relaxed);
+
+            if (a_intervalSeconds > 0 && !exporter.joinable()) {
+                exporter = std::jthread([this](std::stop_token stop) { ExportLoop(stop); });
+                logger::info("Telemetry export every {}s", a_intervalSeconds);
+            } else if (a_intervalSeconds == 0 && exporter.joinable()) {
+                Stop();
+            }
+        }
+
+        // Signals the exporter to stop and hands it to a worker to join, so a file being written is finished
+        // there rather than on the caller's thread
+        void Stop() {
+            if (!exporter.joinable()) {
+                return;
+            }
+            exporter.request_stop();
+            ThreadPool::GetSingleton()->Submit([retired = std::move(exporter)]() mutable { retired.join(); });
+            logger::info("Telemetry export stopped");
+        }
+
+        static std::filesystem::path GetExportPath(Format a_format) {
+            auto name = a_format == Format::kCSV ? "CS_CombatClasses_telemetry.csv"sv : "CS_CombatClasses_telemetry.json"sv;
+            auto logsFolder = SKSE::log::log_directory();
+            return logsFolder ? *logsFolder / name : std::filesystem::path(name);
+        }
+
+    private:
+        struct Row {
+            RE::FormID key;
+            std::array<std::uint64_t, static_cast<std::size_t>(Counter::kCount)> values;
+        };
+
+        template <std::size_t N>
+        static std::vector<Row> Snapshot(const Table<N>& table) {
+            std::vector<Row> rows;
+            for (const auto& slot : table.slots) {
+                auto key = slot.key.load(std::memory_order_acquire);
+                if (key == 0) {
+                    continue;
+                }
+                Row row{ key, {} };
+                for (std::size_t i = 0; i < row.values.size(); ++i) {
+                    row.values[i] = slot.values[i].load(std::memory_order_relaxed);
+                }
+                rows.push_back(row);
+            }
+            std::ranges::sort(rows, {}, &Row::key);
+            return rows;
+        }
+
+        void ExportLoop(std::stop_token stop) {
+            auto lastExport = std::chrono::steady_clock::now();
+            while (!stop.stop_requested()) {
+                // Wakes at once when asked to stop; otherwise checks once a second so interval changes apply promptly
+                {
+                    std::unique_lock guard(exporterLock);
+                    exporterWake.wait_for(guard, stop, std::chrono::seconds(1), [] { return false; });
+                }
+                if (stop.stop_requested()) {
+                    return;
+                }
+
+                auto interval = intervalSeconds.load(std::memory_order_relaxed);
+                auto now = std::chrono::steady_clock::now();
+                if (interval == 0 || now - lastExport < std::chrono::seconds(interval)) {
+                    continue;
+                }
+                lastExport = now;
+                Export(format.load(std::memory_order_relaxed));
+            }
+        }
+
+        void Export(Format a_format) {
+            std::scoped_lock guard(exportLock);
+            auto actorRows = Snapshot(actors);
+            auto weaponRows = Snapshot(weapons);
+
+            // Written next to the target and swapped in, so readers never see half a file
+            auto path = GetExportPath(a_format);
+            auto temporary = path;
+            temporary += ".tmp";
+            {
+                std::ofstream file(temporary, std::ios::trunc);
+                if (!file) {
+                    return;
+                }
+                if (a_format == Format::kCSV) {
+                    WriteCSV(file, actorRows, weaponRows);
+                } else {
+                    WriteJSON(file, actorRows, weaponRows);
+                }
+            }
+            std::error_code error;
+            std::filesystem::rename(temporary, path, error);
+        }
+
+        void WriteJSON(std::ofstream& file, const std::vector<Row>& actorRows, const std::vector<Row>& weaponRows) const {
+            auto toJson = [](const std::vector<Row>& rows) {
+                auto list = nlohmann::json::array();
+                for (const auto& row : rows) {
+                    nlohmann::json entry;
+                    entry["formID"] = fmt::format("{:08X}", row.key);
+                    for (std::size_t i = 0; i < row.values.size(); ++i) {
+                        entry[std::string(counterNames[i])] = row.values[i];
+                    }
+                    list.push_back(std::move(entry));
+                }
+                return list;
+            };
+
+            nlohmann::json document;
+            document["actors"] = toJson(actorRows);
+            document["weapons"] = toJson(weaponRows);
+            document["overflow"] = {
+                { "actors", actors.overflow.load(std::memory_order_relaxed) },
+                { "weapons", weapons.overflow.load(std::memory_order_relaxed) }
+            };
+            file << document.dump(2);
+        }
+
+        static void WriteCSV(std::ofstream& file, const std::vector<Row>& actorRows, const std::vector<Row>& weaponRows) {
+            file << "scope,formID";
+            for (auto name : counterNames) {
+                file << ',' << name;
+            }
+            file << '\n';
+
+            auto writeRows = [&](std::string_view scope, const std::vector<Row>& rows) {
+                for (const auto& row : rows) {
+                    file << scope << ',' << fmt::format("{:08X}", row.key);
+                    for (auto value : row.values) {
+                        file << ',' << value;
+                    }
+                    file << '\n';
+                }
+            };
+            writeRows("actor"sv, actorRows);
+            writeRows("weapon"sv, weaponRows);
+        }
+    };
+
+    inline bool IsCounting() {
+        return Registry::GetSingleton()->IsCounting();
+    }
+
+    inline void Add(Counter counter, RE::FormID actor, RE::FormID weapon = 0, std::uint64_t amount = 1) {
+        Registry::GetSingleton()->Add(counter, actor, weapon, amount);
+    }
+}
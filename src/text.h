@@ -0,0 +1,298 @@
+#pragma once
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Allocation-free text handling. Everything here works on string_views into a buffer the caller keeps
+// alive, compares ASCII case-insensitively without building lowered copies, and parses numbers with
+// from_chars instead of locale-dependent C functions.
+namespace Text {
+    constexpr char ToLower(char ch) {
+        return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+    }
+
+    constexpr char ToUpper(char ch) {
+        return ch >= 'a' && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch;
+    }
+
+    constexpr bool IsSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\v' || ch == '\f';
+    }
+
+    constexpr std::string_view Trim(std::string_view text) {
+        while (!text.empty() && IsSpace(text.front())) text.remove_prefix(1);
+        while (!text.empty() && IsSpace(text.back())) text.remove_suffix(1);
+        return text;
+    }
+
+    constexpr bool IEquals(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            if (ToLower(a[i]) != ToLower(b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr bool IContains(std::string_view haystack, std::string_view needle) {
+        if (needle.size() > haystack.size()) {
+            return false;
+        }
+        for (std::size_t start = 0; start + needle.size() <= haystack.size(); ++start) {
+            if (IEquals(haystack.substr(start, needle.size()), needle)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Case-insensitive hash and equality for unordered containers, transparent so lookups by view don't allocate
+    struct IHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view text) const {
+            // FNV-1a over the lowered bytes
+            std::size_t hash = 14695981039346656037ull;
+            for (auto ch : text) {
+                hash ^= static_cast<unsigned char>(ToLower(ch));
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+
+    struct IEqual {
+        using is_transparent = void;
+
+        bool operator()(std::string_view a, std::string_view b) const { return IEquals(a, b); }
+    };
+
+    // Parses the whole (trimmed) view as a number. A leading '+' is accepted; trailing text is not.
+    template <class T>
+    std::optional<T> ParseNumber(std::string_view text, int base = 10) {
+        text = Trim(text);
+        if (!text.empty() && text.front() == '+') {
+            text.remove_prefix(1);
+        }
+
+        T value{};
+        std::from_chars_result result;
+        if constexpr (std::is_floating_point_v<T>) {
+            result = std::from_chars(text.data(), text.data() + text.size(), value);
+        } else {
+            if (base == 16 && text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+                text.remove_prefix(2);
+            }
+            result = std::from_chars(text.data(), text.data() + text.size(), value, base);
+        }
+        if (result.ec != std::errc{} || result.ptr != text.data() + text.size() || text.empty()) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    inline std::optional<bool> ParseBool(std::string_view text) {
+        text = Trim(text);
+        if (IEquals(text, "true") || IEquals(text, "yes") || IEquals(text, "on") || text == "1") return true;
+        if (IEquals(text, "false") || IEquals(text, "no") || IEquals(text, "off") || text == "0") return false;
+        return std::nullopt;
+    }
+
+    // Lazily yields the pieces of a view between delimiters. Empty pieces are kept, like string splits usually do.
+    class Tokenizer {
+    private:
+        std::string_view rest;
+        std::string_view delimiter;
+        bool done = false;
+
+    public:
+        Tokenizer(std::string_view text, std::string_view a_delimiter) : rest(text), delimiter(a_delimiter) {}
+
+        std::optional<std::string_view> Next() {
+            if (done) {
+                return std::nullopt;
+            }
+
+            auto position = delimiter.empty() ? std::string_view::npos : rest.find(delimiter);
+            if (position == std::string_view::npos) {
+                done = true;
+                return rest;
+            }
+
+            auto token = rest.substr(0, position);
+            rest.remove_prefix(position + delimiter.size());
+            return token;
+        }
+
+        // Calls visitor(token) for every token; stops early if it returns false
+        template <class Visitor>
+        void ForEach(Visitor&& visitor) {
+            while (auto token = Next()) {
+                if constexpr (std::is_same_v<std::invoke_result_t<Visitor, std::string_view>, bool>) {
+                    if (!visitor(*token)) {
+                        return;
+                    }
+                } else {
+                    visitor(*token);
+                }
+            }
+        }
+    };
+
+    // A whole file read with one allocation, handed out as a view. Kept instead of a memory mapping so
+    // this header doesn't drag <Windows.h> and its macros into every translation unit.
+    class FileBuffer {
+    private:
+        std::unique_ptr<char[]> data;
+        std::size_t size = 0;
+
+    public:
+        bool Open(const std::filesystem::path& path) {
+            data.reset();
+            size = 0;
+
+            std::ifstream stream(path, std::ios::binary | std::ios::ate);
+            if (!stream) {
+                return false;
+            }
+
+            auto length = static_cast<std::streamoff>(stream.tellg());
+            if (length < 0) {
+                return false;
+            }
+            stream.seekg(0);
+
+            size = static_cast<std::size_t>(length);
+            data = std::make_unique_for_overwrite<char[]>(size);
+            return static_cast<bool>(stream.read(data.get(), static_cast<std::streamsize>(size)));
+        }
+
+        std::string_view Contents() const { return { data.get(), size }; }
+    };
+
+    // INI document indexed in place over the file buffer. Sections and keys keep their file order and
+    // every name and value is a view into the buffer, so loading allocates only the buffer and the index.
+    // Lines starting with ';' or '#' are comments, as is anything after a ';' that follows whitespace.
+    // A section header that repeats an earlier one, in any case, continues that section, so its keys
+    // are merged in file order and a later value still wins.
+    class IniDocument {
+    public:
+        struct Entry {
+            std::string_view key;
+            std::string_view value;
+        };
+
+        struct Section {
+            std::string_view name;
+            std::vector<Entry> entries;
+
+            // Last value set for the key, like a plain INI reader; keys compare case-insensitively
+            std::optional<std::string_view> Find(std::string_view key) const {
+                for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+                    if (IEquals(it->key, key)) {
+                        return it->value;
+                    }
+                }
+                return std::nullopt;
+            }
+
+            std::string_view GetValue(std::string_view key, std::string_view fallback = {}) const {
+                return Find(key).value_or(fallback);
+            }
+
+            template <class T>
+            T GetNumber(std::string_view key, T fallback) const {
+                auto value = Find(key);
+                if (!value) {
+                    return fallback;
+                }
+                return ParseNumber<T>(*value).value_or(fallback);
+            }
+
+            bool GetBool(std::string_view key, bool fallback) const {
+                auto value = Find(key);
+                return value ? ParseBool(*value).value_or(fallback) : fallback;
+            }
+        };
+
+    private:
+        FileBuffer file;
+        std::vector<Section> sections;
+
+    public:
+        bool Load(const std::filesystem::path& path) {
+            sections.clear();
+            if (!file.Open(path)) {
+                return false;
+            }
+
+            auto contents = file.Contents();
+
+            // Skip a UTF-8 byte order mark
+            if (contents.starts_with("\xEF\xBB\xBF"sv)) {
+                contents.remove_prefix(3);
+            }
+
+            // Keys before the first header belong to an unnamed section
+            sections.push_back({});
+            std::size_t current = 0;
+
+            Tokenizer lines(contents, "\n"sv);
+            lines.ForEach([this, &current](std::string_view line) {
+                line = Trim(line);
+                if (line.empty() || line.front() == ';' || line.front() == '#') {
+                    return;
+                }
+
+                if (line.front() == '[') {
+                    auto close = line.find(']');
+                    if (close != std::string_view::npos) {
+                        auto name = Trim(line.substr(1, close - 1));
+                        auto existing = std::ranges::find_if(sections, [name](const Section& section) { return IEquals(section.name, name); });
+                        current = static_cast<std::size_t>(existing - sections.begin());
+                        if (existing == sections.end()) {
+                            sections.push_back({ name, {} });
+                        }
+                    }
+                    return;
+                }
+
+                auto equals = line.find('=');
+                if (equals == std::string_view::npos) {
+                    return;
+                }
+
+                auto value = line.substr(equals + 1);
+                for (std::size_t i = 1; i < value.size(); ++i) {
+                    if (value[i] == ';' && IsSpace(value[i - 1])) {
+                        value = value.substr(0, i);
+                        break;
+                    }
+                }
+                sections[current].entries.push_back({ Trim(line.substr(0, equals)), Trim(value) });
+            });
+
+            return true;
+        }
+
+        // Sections in file order, starting with the unnamed one
+        const std::vector<Section>& GetSections() const { return sections; }
+
+        const Section* FindSection(std::string_view name) const {
+            for (const auto& section : sections) {
+                if (IEquals(section.name, name)) {
+                    return &section;
+                }
+            }
+            return nullptr;
+        }
+    };
+}
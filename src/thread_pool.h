@@ -0,0 +1,233 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Small work-stealing pool for jobs that only need a snapshot of game state.
+// Jobs run on workers; continuations are marshalled back to the game thread and
+// drained in one SKSE task per frame.
+class ThreadPool {
+public:
+    using Job = std::move_only_function<void()>;
+
+private:
+    static inline ThreadPool* instance = nullptr;
+
+    // Leave the game's own threads some room
+    static constexpr std::uint32_t maxWorkers = 4;
+
+    struct Worker {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::jthread> threads;
+
+    std::mutex sleepLock;
+    std::condition_variable_any wake;
+    // Jobs sitting in the queues. Only changed under the lock of the queue the job enters or leaves.
+    std::atomic<std::uint32_t> pendingJobs{ 0 };
+    std::atomic<std::uint32_t> nextQueue{ 0 };
+    std::atomic<bool> running{ false };
+
+    // Continuations waiting for the game thread
+    std::mutex completedLock;
+    std::vector<Job> completed;
+    std::vector<Job> draining;
+    std::atomic<bool> flushQueued{ false };
+
+    // Stats
+    std::atomic<std::uint64_t> executedJobs{ 0 };
+    std::atomic<std::uint64_t> maxQueueLatencyUs{ 0 };
+
+    static inline thread_local std::uint32_t workerIndex = UINT32_MAX;
+
+    ThreadPool() = default;
+
+public:
+    static ThreadPool* GetSingleton() {
+        if (!instance) {
+            instance = new ThreadPool();
+        }
+        return instance;
+    }
+
+    static std::uint32_t GetDefaultWorkerCount() {
+        auto hardware = std::thread::hardware_concurrency();
+        return std::clamp(hardware > 1 ? hardware - 1 : 1u, 1u, maxWorkers);
+    }
+
+    // The pool lives as long as the process. Workers are not joined at exit: by the time static destructors
+    // or atexit handlers run inside the DLL the loader lock is held, and joining there can deadlock.
+    void Start(std::uint32_t workerCount = GetDefaultWorkerCount()) {
+        if (running.exchange(true)) {
+            return;
+        }
+
+        workers.clear();
+        for (std::uint32_t i = 0; i < workerCount; ++i) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (std::uint32_t i = 0; i < workerCount; ++i) {
+            threads.emplace_back([this, i](std::stop_token stop) { WorkerLoop(stop, i); });
+        }
+
+        logger::info("Started thread pool with {} workers", workerCount);
+    }
+
+    // Stops and joins all workers. Jobs that never started are dropped. Not for use during process teardown.
+    void Shutdown() {
+        if (!running.exchange(false)) {
+            return;
+        }
+
+        for (auto& thread : threads) {
+            thread.request_stop();
+        }
+        wake.notify_all();
+        threads.clear();
+
+        for (auto& worker : workers) {
+            std::scoped_lock guard(worker->lock);
+            worker->jobs.clear();
+        }
+        pendingJobs = 0;
+
+        logger::info("Thread pool stopped after {} jobs (max queue latency {}us)", executedJobs.load(), maxQueueLatencyUs.load());
+    }
+
+    std::size_t GetWorkerCount() const { return threads.size(); }
+
+    // Fire-and-forget job on a worker
+    void Submit(Job job) {
+        if (!running) {
+            Start();
+        }
+
+        auto enqueued = std::chrono::steady_clock::now();
+        Job timed = [this, enqueued, job = std::move(job)]() mutable {
+            RecordLatency(enqueued);
+            job();
+        };
+
+        // Jobs spawned by a worker stay on its own queue; everything else is spread round-robin
+        auto index = workerIndex != UINT32_MAX ? workerIndex : nextQueue.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        {
+            std::scoped_lock guard(workers[index]->lock);
+            workers[index]->jobs.push_back(std::move(timed));
+            pendingJobs.fetch_add(1, std::memory_order_release);
+        }
+        {
+            // Pairs with the predicate check in WorkerLoop so the wakeup can't slip in before a worker sleeps
+            std::scoped_lock guard(sleepLock);
+        }
+        wake.notify_one();
+    }
+
+    // Runs job on a worker, then continuation(result) on the game thread
+    template <class F, class C>
+    void Submit(F&& job, C&& continuation) {
+        using Result = std::invoke_result_t<F>;
+
+        Submit([this, job = std::forward<F>(job), continuation = std::forward<C>(continuation)]() mutable {
+            if constexpr (std::is_void_v<Result>) {
+                job();
+                PostToGameThread(std::move(continuation));
+            } else {
+                PostToGameThread([result = job(), continuation = std::move(continuation)]() mutable {
+                    continuation(std::move(result));
+                });
+            }
+        });
+    }
+
+    // Queues work for the game thread. All work posted before the next frame runs in a single task.
+    void PostToGameThread(Job job) {
+        {
+            std::scoped_lock guard(completedLock);
+            completed.push_back(std::move(job));
+        }
+
+        if (!flushQueued.exchange(true, std::memory_order_acq_rel)) {
+            SKSE::GetTaskInterface()->AddTask([this]() { FlushCompleted(); });
+        }
+    }
+
+private:
+    void FlushCompleted() {
+        {
+            std::scoped_lock guard(completedLock);
+            std::swap(draining, completed);
+            flushQueued.store(false, std::memory_order_release);
+        }
+
+        for (auto& job : draining) {
+            job();
+        }
+        draining.clear();
+    }
+
+    void WorkerLoop(std::stop_token stop, std::uint32_t index) {
+        workerIndex = index;
+
+        while (!stop.stop_requested()) {
+            Job job;
+            if (TryPop(index, job) || TrySteal(index, job)) {
+                try {
+                    job();
+                } catch (const std::exception& e) {
+                    logger::error("Worker job failed: {}", e.what());
+                }
+                executedJobs.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            // A non-zero count means a job is in some queue, which the next pass is guaranteed to find
+            std::unique_lock guard(sleepLock);
+            wake.wait(guard, stop, [this] { return pendingJobs.load(std::memory_order_acquire) > 0; });
+        }
+    }
+
+    bool TryPop(std::uint32_t index, Job& job) {
+        auto& worker = *workers[index];
+        std::scoped_lock guard(worker.lock);
+        if (worker.jobs.empty()) {
+            return false;
+        }
+        job = std::move(worker.jobs.back());
+        worker.jobs.pop_back();
+        pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    bool TrySteal(std::uint32_t index, Job& job) {
+        for (std::size_t offset = 1; offset < workers.size(); ++offset) {
+            // Queue locks are only held to push or pop, so waiting for one is cheaper than skipping it
+            // and coming straight back because the job count still says there is work
+            auto& victim = *workers[(index + offset) % workers.size()];
+            std::scoped_lock guard(victim.lock);
+            if (victim.jobs.empty()) {
+                continue;
+            }
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+        return false;
+    }
+
+    void RecordLatency(std::chrono::steady_clock::time_point enqueued) {
+        auto latency = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - enqueued).count());
+        auto current = maxQueueLatencyUs.load(std::memory_order_relaxed);
+        while (latency > current && !maxQueueLatencyUs.compare_exchange_weak(current, latency, std::memory_order_relaxed)) {
+        }
+    }
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cmath>
+#include <numbers>
+#include "fixed_containers.h"
+
+// Who is hurting the party. Every hit on a follower or the player adds threat for the attacker in that
+// victim's table, and threat halves every fThreatHalfLife seconds. Tables are fixed size so the whole
+// map stays a few cache lines even in large battles.
+//
+// Decay is lazy: scores are stored scaled up by the decay accumulated since a shared epoch, so a hit
+// only adds to one slot and every score decays by the same factor. That keeps the order between
+// enemies fixed, so each table tracks its top slot as hits arrive and reading it is O(1). The target
+// allocator reads only that top enemy per follower. Calls take the time, defaulting to now, so tests
+// can step it.
+namespace CombatClasses {
+    class ThreatMap {
+    public:
+        static constexpr std::size_t slotsPerTable = 8;
+        static constexpr std::size_t maxTables = 17;  // every follower the allocator handles, plus the player
+
+    private:
+        static inline ThreatMap* instance = nullptr;
+
+        static constexpr std::uint8_t noSlot = 0xFF;
+
+        // Scores are rescaled before the epoch factor gets large enough to cost float precision
+        static constexpr float maxEpochExponent = 20.0f;
+
+        struct Slot {
+            RE::FormID enemy = 0;
+            float score = 0.0f;
+        };
+
+        struct Table {
+            RE::FormID victim = 0;
+            std::array<Slot, slotsPerTable> slots{};
+            std::uint8_t top = noSlot;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        FixedVector<Table, maxTables> tables;
+        Clock::time_point epoch = Clock::now();
+
+        // fThreatHalfLife, pushed in when settings load. 0 turns decay off.
+        float halfLife = 10.0f;
+
+        std::uint64_t hits = 0;
+        std::uint64_t evictions = 0;
+        std::uint64_t droppedHits = 0;
+
+        ThreatMap() = default;
+
+    public:
+        static ThreatMap* GetSingleton() {
+            if (!instance) {
+                instance = new ThreatMap();
+            }
+            return instance;
+        }
+
+        void SetHalfLife(float seconds) { halfLife = seconds; }
+
+        // Adds threat from attacker against victim. O(slotsPerTable) at worst, when a slot has to be evicted.
+        void AddHit(RE::FormID victim, RE::FormID attacker, float amount, Clock::time_point now = Clock::now()) {
+            auto table = FindTable(victim);
+            if (!table) {
+                if (!tables.push_back({ victim })) {
+                    ++droppedHits;
+                    return;
+                }
+                table = &tables[tables.size() - 1];
+            }
+
+            auto exponent = Exponent(now);
+            if (exponent > maxEpochExponent) {
+                Rebase(exponent, now);
+                exponent = 0.0f;
+            }
+            auto scaled = amount * std::exp(exponent);
+
+            // The attacker's slot, else an empty one, else the weakest
+            std::uint8_t target = noSlot;
+            std::uint8_t weakest = 0;
+            for (std::uint8_t i = 0; i < slotsPerTable; ++i) {
+                const auto& slot = table->slots[i];
+                if (slot.enemy == attacker) {
+                    target = i;
+                    break;
+                }
+                if (slot.score < table->slots[weakest].score) {
+                    weakest = i;
+                }
+            }
+            if (target == noSlot) {
+                target = weakest;
+                if (table->slots[target].enemy != 0) {
+                    ++evictions;
+                }
+                table->slots[target] = { attacker, 0.0f };
+                if (table->top == target) {
+                    table->top = noSlot;
+                }
+            }
+
+            auto& slot = table->slots[target];
+            slot.score += scaled;
+            ++hits;
+
+            // Scores only grow between rebases, so the top can only move to the slot just hit
+            if (table->top == noSlot) {
+                table->top = HighestSlot(*table);
+            } else if (slot.score > table->slots[table->top].score) {
+                table->top = target;
+            }
+        }
+
+        // The enemy that has hurt this victim most recently and heavily, or 0 once its decayed threat
+        // has fallen below minimum
+        RE::FormID GetTopThreat(RE::FormID victim, float minimum = 0.0f, Clock::time_point now = Clock::now()) const {
+            auto table = FindTable(victim);
+            if (!table || table->top == noSlot) {
+                return 0;
+            }
+            const auto& top = table->slots[table->top];
+            return top.score * std::exp(-Exponent(now)) >= minimum ? top.enemy : 0;
+        }
+
+        // Current decayed threat of attacker against victim
+        float GetThreat(RE::FormID victim, RE::FormID attacker, Clock::time_point now = Clock::now()) const {
+            auto table = FindTable(victim);
+            if (!table) {
+                return 0.0f;
+            }
+            for (const auto& slot : table->slots) {
+                if (slot.enemy == attacker) {
+                    return slot.score * std::exp(-Exponent(now));
+                }
+            }
+            return 0.0f;
+        }
+
+        void Clear(Clock::time_point now = Clock::now()) {
+            if (tables.empty()) {
+                return;
+            }
+            tables.clear();
+            epoch = now;
+            logger::debug("Threat: {} hits, {} evictions, {} dropped", hits, evictions, droppedHits);
+        }
+
+    private:
+        Table* FindTable(RE::FormID victim) {
+            auto it = std::ranges::find(tables, victim, &Table::victim);
+            return it != tables.end() ? it : nullptr;
+        }
+
+        const Table* FindTable(RE::FormID victim) const {
+            auto it = std::ranges::find(tables, victim, &Table::victim);
+            return it != tables.end() ? it : nullptr;
+        }
+
+        // Natural log of the decay accumulated since the epoch
+        float Exponent(Clock::time_point now) const {
+            if (halfLife <= 0.0f) {
+                return 0.0f;
+            }
+            auto elapsed = std::chrono::duration<float>(now - epoch).count();
+            return elapsed * std::numbers::ln2_v<float> / halfLife;
+        }
+
+        // Applies the accumulated decay to every score and restarts the epoch
+        void Rebase(float exponent, Clock::time_point now) {
+            auto factor = std::exp(-exponent);
+            for (auto& table : tables) {
+                for (auto& slot : table.slots) {
+                    slot.score *= factor;
+                }
+            }
+            epoch = now;
+        }
+
+        static std::uint8_t HighestSlot(const Table& table) {
+            std::uint8_t best = noSlot;
+            for (std::uint8_t i = 0; i < slotsPerTable; ++i) {
+                if (table.slots[i].enemy != 0 && (best == noSlot || table.slots[i].score > table.slots[best].score)) {
+                    best = i;
+                }
+            }
+            return best;
+        }
+    };
+}
@@ -0,0 +1,327 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Timers for cooldowns and effect durations. Scheduling, cancelling and expiring are O(1) however many
+// timers are live, so effects can keep one per actor instead of polling timestamps every tick.
+namespace Timers {
+    // Handle to a scheduled timer. Stays safe to cancel after the timer fired or was cancelled.
+    using TimerID = std::uint64_t;
+    inline constexpr TimerID kNoTimer = 0;
+
+    // Hierarchical timing wheel: four levels of 256 slots, each level covering 256 times the span of the
+    // one below. A timer sits in the coarsest slot that holds its deadline and moves down a level each time
+    // the wheel below completes a turn, until it fires from the finest level. Advancing jumps straight to
+    // the next occupied slot, so long gaps between updates cost nothing when little is scheduled.
+    class TimingWheel {
+    public:
+        using Callback = std::function<void()>;
+
+    private:
+        static constexpr std::uint32_t slotBits = 8;
+        static constexpr std::uint32_t slotCount = 1u << slotBits;
+        static constexpr std::uint32_t slotMask = slotCount - 1;
+        static constexpr std::uint32_t levelCount = 4;
+        static constexpr std::uint32_t none = UINT32_MAX;
+
+        // Furthest a deadline can be, in ticks; later ones are clamped
+        static constexpr std::uint64_t maxDelay = (1ull << (slotBits * levelCount)) - 1;
+
+        struct Timer {
+            std::uint64_t deadline = 0;
+            Callback callback;
+            std::uint32_t previous = none;
+            std::uint32_t next = none;
+            std::uint32_t generation = 1;
+            std::uint32_t slot = none;  // level * slotCount + index while scheduled
+        };
+
+        struct Level {
+            std::array<std::uint32_t, slotCount> heads;
+            std::array<std::uint64_t, slotCount / 64> occupied{};
+
+            Level() { heads.fill(none); }
+        };
+
+        std::chrono::microseconds resolution;
+        std::chrono::microseconds remainder{ 0 };
+        std::uint64_t now = 0;
+        std::array<Level, levelCount> levels;
+
+        // Timer storage, reused through a free list so steady-state scheduling doesn't allocate
+        std::vector<Timer> timers;
+        std::vector<std::uint32_t> freeTimers;
+        std::size_t liveTimers = 0;
+
+    public:
+        explicit TimingWheel(std::chrono::microseconds a_resolution = std::chrono::milliseconds(1)) :
+            resolution(a_resolution) {}
+
+        // Runs callback once delay has passed, on the first Advance at or after the deadline
+        template <class Rep, class Period>
+        TimerID Schedule(std::chrono::duration<Rep, Period> delay, Callback callback) {
+            // Counted from the current time, not the last whole tick, and rounded up, so a timer never fires early
+            auto micros = std::chrono::ceil<std::chrono::microseconds>(delay).count() + remainder.count();
+            auto ticks = (micros + resolution.count() - 1) / resolution.count();
+            return ScheduleTicks(ticks > 0 ? static_cast<std::uint64_t>(ticks) : 0, std::move(callback));
+        }
+
+        // Returns false if the timer already fired or was cancelled
+        bool Cancel(TimerID id) {
+            auto index = Find(id);
+            if (index == none) {
+                return false;
+            }
+            Unlink(index);
+            Release(index);
+            return true;
+        }
+
+        bool IsScheduled(TimerID id) const { return Find(id) != none; }
+
+        std::size_t size() const { return liveTimers; }
+        bool empty() const { return liveTimers == 0; }
+
+        // Moves the wheel forward by elapsed time and fires everything that came due, in deadline order
+        template <class Rep, class Period>
+        void Advance(std::chrono::duration<Rep, Period> elapsed) {
+            if (elapsed <= elapsed.zero()) {
+                return;
+            }
+
+            // Whatever doesn't make up a whole tick carries over, so frame times don't drift
+            remainder += std::chrono::duration_cast<std::chrono::microseconds>(elapsed);
+            auto ticks = remainder / resolution;
+            remainder -= ticks * resolution;
+            if (ticks > 0) {
+                AdvanceTicks(static_cast<std::uint64_t>(ticks));
+            }
+        }
+
+        // Drops every timer without firing it
+        void Clear() {
+            for (auto& level : levels) {
+                level.heads.fill(none);
+                level.occupied.fill(0);
+            }
+            for (std::uint32_t i = 0; i < timers.size(); ++i) {
+                if (timers[i].slot != none) {
+                    timers[i].slot = none;
+                    Release(i);
+                }
+            }
+        }
+
+    private:
+        TimerID ScheduleTicks(std::uint64_t ticks, Callback callback) {
+            std::uint32_t index;
+            if (!freeTimers.empty()) {
+                index = freeTimers.back();
+                freeTimers.pop_back();
+            } else {
+                index = static_cast<std::uint32_t>(timers.size());
+                timers.emplace_back();
+            }
+
+            auto& timer = timers[index];
+            timer.deadline = now + std::clamp<std::uint64_t>(ticks, 1, maxDelay);
+            timer.callback = std::move(callback);
+            ++liveTimers;
+            Link(index);
+
+            return (static_cast<std::uint64_t>(timer.generation) << 32) | index;
+        }
+
+        std::uint32_t Find(TimerID id) const {
+            auto index = static_cast<std::uint32_t>(id);
+            auto generation = static_cast<std::uint32_t>(id >> 32);
+            if (index >= timers.size() || timers[index].generation != generation || timers[index].slot == none) {
+                return none;
+            }
+            return index;
+        }
+
+        void Release(std::uint32_t index) {
+            auto& timer = timers[index];
+            timer.callback = nullptr;
+            // Invalidates outstanding IDs; skips 0 so an ID is never kNoTimer
+            if (++timer.generation == 0) {
+                timer.generation = 1;
+            }
+            freeTimers.push_back(index);
+            --liveTimers;
+        }
+
+        // Files a timer into the slot matching how far its deadline is from now
+        void Link(std::uint32_t index) {
+            auto& timer = timers[index];
+            auto delay = timer.deadline - now;
+
+            std::uint32_t level = 0;
+            while (level + 1 < levelCount && delay >= (1ull << (slotBits * (level + 1)))) {
+                ++level;
+            }
+            auto slotIndex = static_cast<std::uint32_t>(timer.deadline >> (slotBits * level)) & slotMask;
+
+            auto& head = levels[level].heads[slotIndex];
+            timer.slot = level * slotCount + slotIndex;
+            timer.previous = none;
+            timer.next = head;
+            if (head != none) {
+                timers[head].previous = index;
+            }
+            head = index;
+            levels[level].occupied[slotIndex >> 6] |= 1ull << (slotIndex & 63);
+        }
+
+        void Unlink(std::uint32_t index) {
+            auto& timer = timers[index];
+            auto& level = levels[timer.slot / slotCount];
+            auto slotIndex = timer.slot & slotMask;
+
+            if (timer.previous != none) {
+                timers[timer.previous].next = timer.next;
+            } else {
+                level.heads[slotIndex] = timer.next;
+            }
+            if (timer.next != none) {
+                timers[timer.next].previous = timer.previous;
+            }
+            if (level.heads[slotIndex] == none) {
+                level.occupied[slotIndex >> 6] &= ~(1ull << (slotIndex & 63));
+            }
+            timer.slot = none;
+        }
+
+        // First occupied slot of the finest level at or after from, or slotCount
+        std::uint32_t NextOccupied(std::uint32_t from) const {
+            const auto& occupied = levels[0].occupied;
+            for (auto word = from >> 6; word < occupied.size(); ++word) {
+                auto bits = occupied[word];
+                if (word == from >> 6) {
+                    bits &= ~0ull << (from & 63);
+                }
+                if (bits) {
+                    return word * 64 + static_cast<std::uint32_t>(std::countr_zero(bits));
+                }
+            }
+            return slotCount;
+        }
+
+        void AdvanceTicks(std::uint64_t ticks) {
+            auto target = now + ticks;
+            while (now < target) {
+                if (liveTimers == 0) {
+                    now = target;
+                    return;
+                }
+
+                // Next tick that either has timers due or turns the finest level over
+                auto index = static_cast<std::uint32_t>(now & slotMask);
+                auto next = NextOccupied(index + 1);
+                auto nextTick = now - index + next;  // equals the turnover tick when nothing is occupied
+                if (nextTick > target) {
+                    now = target;
+                    return;
+                }
+
+                now = nextTick;
+                if ((now & slotMask) == 0) {
+                    Cascade(1);
+                }
+                Expire(static_cast<std::uint32_t>(now & slotMask));
+            }
+        }
+
+        // Moves the timers of the slot that just came up on a coarser level down to finer ones
+        void Cascade(std::uint32_t level) {
+            if (level >= levelCount) {
+                return;
+            }
+
+            auto slotIndex = static_cast<std::uint32_t>(now >> (slotBits * level)) & slotMask;
+            // That level turned over too, so its parent hands down first
+            if (slotIndex == 0) {
+                Cascade(level + 1);
+            }
+
+            auto& head = levels[level].heads[slotIndex];
+            while (head != none) {
+                auto index = head;
+                Unlink(index);
+                Link(index);
+            }
+        }
+
+        void Expire(std::uint32_t slotIndex) {
+            auto& head = levels[0].heads[slotIndex];
+            while (head != none) {
+                auto index = head;
+                Unlink(index);
+
+                // The callback may schedule or cancel timers, which can reallocate storage
+                auto callback = std::move(timers[index].callback);
+                Release(index);
+                if (callback) {
+                    callback();
+                }
+            }
+        }
+    };
+
+    enum class Clock : std::uint8_t {
+        kGame,  // stops while the game is paused, e.g. in menus
+        kReal   // wall time
+    };
+
+    // The plugin's two wheels, advanced from the update tick on the game thread. The tick only runs while
+    // followers fight, so game clock timers also hold still between fights; real clock ones catch up.
+    class Scheduler {
+    private:
+        static inline Scheduler* instance = nullptr;
+
+        TimingWheel gameWheel;
+        TimingWheel realWheel;
+        std::chrono::steady_clock::time_point lastAdvance = std::chrono::steady_clock::now();
+
+        Scheduler() = default;
+
+    public:
+        static Scheduler* GetSingleton() {
+            if (!instance) {
+                instance = new Scheduler();
+            }
+            return instance;
+        }
+
+        TimingWheel& Get(Clock clock) { return clock == Clock::kGame ? gameWheel : realWheel; }
+
+        template <class Rep, class Period>
+        TimerID Schedule(Clock clock, std::chrono::duration<Rep, Period> delay, TimingWheel::Callback callback) {
+            return Get(clock).Schedule(delay, std::move(callback));
+        }
+
+        bool Cancel(Clock clock, TimerID id) { return Get(clock).Cancel(id); }
+
+        // Fires everything that came due since the last tick
+        void Advance() {
+            auto now = std::chrono::steady_clock::now();
+            auto realElapsed = now - lastAdvance;
+            lastAdvance = now;
+
+            gameWheel.Advance(std::chrono::duration<float>(RE::GetSecondsSinceLastFrame()));
+            realWheel.Advance(realElapsed);
+        }
+
+        // Drops every timer on both clocks without firing it, e.g. when another save loads
+        void Clear() {
+            gameWheel.Clear();
+            realWheel.Clear();
+            lastAdvance = std::chrono::steady_clock::now();
+        }
+    };
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <ranges>
+#include <span>
+#include "text.h"
+#include "fixed_strings.h"
+#include "fixed_containers.h"
 
 #define PI 3.1415926535897932f
 #define TWOTHIRDS_PI 2.0943951023931955f
@@ -129,70 +133,68 @@ namespace KeyUtil
 
 namespace Util
 {
+    // Thin wrappers over the allocation-free helpers in text.h, kept for existing callers
     struct String
     {
-		static std::vector<std::string> Split(const std::string& a_str, std::string_view a_delimiter)
+		static std::vector<std::string> Split(std::string_view a_str, std::string_view a_delimiter)
 		{
-			auto range = a_str | std::ranges::views::split(a_delimiter) | std::ranges::views::transform([](auto&& r) { return std::string_view(r); });
-			return { range.begin(), range.end() };
+			std::vector<std::string> result;
+			Text::Tokenizer(a_str, a_delimiter).ForEach([&](std::string_view token) { result.emplace_back(token); });
+			return result;
 		}
 
-
-
         static bool iContains(std::string_view a_str1, std::string_view a_str2)
 		{
-			if (a_str2.length() > a_str1.length()) {
-				return false;
-			}
-
-			const auto subrange = std::ranges::search(a_str1, a_str2, [](unsigned char ch1, unsigned char ch2) {
-				return std::toupper(ch1) == std::toupper(ch2);
-			});
-
-			return !subrange.empty();
+			return Text::IContains(a_str1, a_str2);
 		}
 
 		static bool iEquals(std::string_view a_str1, std::string_view a_str2)
 		{
-			return std::ranges::equal(a_str1, a_str2, [](unsigned char ch1, unsigned char ch2) {
-				return std::toupper(ch1) == std::toupper(ch2);
-			});
+			return Text::IEquals(a_str1, a_str2);
 		}
 
-		// https://stackoverflow.com/a/35452044
 		static std::string Join(const std::vector<std::string>& a_vec, std::string_view a_delimiter)
 		{
-			return std::accumulate(a_vec.begin(), a_vec.end(), std::string{},
-				[a_delimiter](const auto& str1, const auto& str2) {
-					return str1.empty() ? str2 : str1 + a_delimiter.data() + str2;
-				});
+			std::size_t length = a_vec.empty() ? 0 : a_delimiter.size() * (a_vec.size() - 1);
+			for (const auto& str : a_vec) {
+				length += str.size();
+			}
+
+			std::string result;
+			result.reserve(length);
+			for (const auto& str : a_vec) {
+				if (!result.empty()) {
+					result += a_delimiter;
+				}
+				result += str;
+			}
+			return result;
 		}
 
-        static std::vector<float> ToFloatVector(const std::vector<std::string> stringVector)
+        // Entries that aren't numbers become 0, as atof would make them
+        static std::vector<float> ToFloatVector(const std::vector<std::string>& stringVector)
         {
-            std::vector<float> floatNumbers; 
-            for(auto str : stringVector)
-            {
-                float num = atof(str.c_str());
-                floatNumbers.push_back(num);
+            std::vector<float> floatNumbers;
+            floatNumbers.reserve(stringVector.size());
+            for (const auto& str : stringVector) {
+                floatNumbers.push_back(Text::ParseNumber<float>(str).value_or(0.0f));
             }
             return floatNumbers;
         }
+
         static std::string ToLower(std::string_view a_str)
 		{
 			std::string result(a_str);
-			std::ranges::transform(result, result.begin(), [](unsigned char ch) { return static_cast<unsigned char>(std::tolower(ch)); });
+			std::ranges::transform(result, result.begin(), Text::ToLower);
 			return result;
 		}
 
 		static std::string ToUpper(std::string_view a_str)
 		{
 			std::string result(a_str);
-			std::ranges::transform(result, result.begin(), [](unsigned char ch) { return static_cast<unsigned char>(std::toupper(ch)); });
+			std::ranges::transform(result, result.begin(), Text::ToUpper);
 			return result;
 		}
-
-
     };
 
 }
@@ -486,6 +488,81 @@ namespace FormUtil
 }
 namespace NifUtil
 {
+    // Depth-first scene graph walks. Unlike RE::BSVisit these take the visitor as a template parameter,
+    // so it is inlined and never boxed into a std::function. A visitor returns kStop to end the walk
+    // early, or nothing to always continue; each walk returns kStop if it was ended early.
+    struct Visit
+    {
+        template <class Visitor, class T>
+        static RE::BSVisit::BSVisitControl Call(Visitor& visitor, T* object)
+        {
+            if constexpr (std::is_void_v<std::invoke_result_t<Visitor&, T*>>) {
+                visitor(object);
+                return RE::BSVisit::BSVisitControl::kContinue;
+            } else {
+                return visitor(object);
+            }
+        }
+
+        // Every object under and including root
+        template <class Visitor>
+        static RE::BSVisit::BSVisitControl Objects(RE::NiAVObject* root, Visitor&& visitor)
+        {
+            if (!root) {
+                return RE::BSVisit::BSVisitControl::kContinue;
+            }
+            if (Call(visitor, root) == RE::BSVisit::BSVisitControl::kStop) {
+                return RE::BSVisit::BSVisitControl::kStop;
+            }
+            if (auto node = root->AsNode()) {
+                for (auto& child : node->GetChildren()) {
+                    if (Objects(child.get(), visitor) == RE::BSVisit::BSVisitControl::kStop) {
+                        return RE::BSVisit::BSVisitControl::kStop;
+                    }
+                }
+            }
+            return RE::BSVisit::BSVisitControl::kContinue;
+        }
+
+        template <class Visitor>
+        static RE::BSVisit::BSVisitControl Nodes(RE::NiAVObject* root, Visitor&& visitor)
+        {
+            return Objects(root, [&](RE::NiAVObject* object) {
+                auto node = object->AsNode();
+                return node ? Call(visitor, node) : RE::BSVisit::BSVisitControl::kContinue;
+            });
+        }
+
+        template <class Visitor>
+        static RE::BSVisit::BSVisitControl Geometries(RE::NiAVObject* root, Visitor&& visitor)
+        {
+            return Objects(root, [&](RE::NiAVObject* object) {
+                auto geometry = object->AsGeometry();
+                return geometry ? Call(visitor, geometry) : RE::BSVisit::BSVisitControl::kContinue;
+            });
+        }
+
+        template <class Visitor>
+        static RE::BSVisit::BSVisitControl Collisions(RE::NiAVObject* root, Visitor&& visitor)
+        {
+            return Objects(root, [&](RE::NiAVObject* object) {
+                auto collision = object->GetCollisionObject();
+                auto bhkCollision = collision ? collision->AsBhkNiCollisionObject() : nullptr;
+                return bhkCollision ? Call(visitor, bhkCollision) : RE::BSVisit::BSVisitControl::kContinue;
+            });
+        }
+
+        // Rigid bodies behind the collision objects, which is where the collision filter lives
+        template <class Visitor>
+        static RE::BSVisit::BSVisitControl Bodies(RE::NiAVObject* root, Visitor&& visitor)
+        {
+            return Collisions(root, [&](RE::bhkNiCollisionObject* collision) {
+                auto body = collision->body ? static_cast<RE::hkpWorldObject*>(collision->body->referencedObject.get()) : nullptr;
+                return body ? Call(visitor, body) : RE::BSVisit::BSVisitControl::kContinue;
+            });
+        }
+    };
+
     struct Node
 		{
             static NiAVObject* Clone(NiAVObject* original)
@@ -514,19 +591,24 @@ namespace NifUtil
             static std::vector<BSGeometry*> GetAllGeometries(RE::NiAVObject* root)
             {
                 std::vector<BSGeometry*> geometries; 
-                RE::BSVisit::TraverseScenegraphGeometries(root, [&](BSGeometry* geom)-> RE::BSVisit::BSVisitControl 
-                {
-                    geometries.emplace_back(geom); 
-                    return RE::BSVisit::BSVisitControl::kContinue;
-                }
-				); 
+                Visit::Geometries(root, [&](BSGeometry* geom) { geometries.emplace_back(geom); });
                 return geometries;
             }
 
+            // Fills a caller-owned buffer instead of allocating. Returns false if the buffer ran out first.
+            template <std::size_t N>
+            static bool GetAllGeometries(RE::NiAVObject* root, FixedVector<BSGeometry*, N>& geometries)
+            {
+                return Visit::Geometries(root, [&](BSGeometry* geom) {
+                    return geometries.push_back(geom) ? RE::BSVisit::BSVisitControl::kContinue : RE::BSVisit::BSVisitControl::kStop;
+                }) == RE::BSVisit::BSVisitControl::kContinue;
+            }
+
 		};
     struct Armature
     {
-        static RE::NiNode* GetActorNode(RE::Actor* actor, std::string nodeName)
+        // Bone names come interned, either from the registry or held by the caller, so lookups never touch the string table
+        static RE::NiNode* GetActorNode(RE::Actor* actor, const RE::BSFixedString& nodeName)
         {
                 auto root = actor->Get3D();
                 if (!root) return nullptr;
@@ -540,9 +622,14 @@ namespace NifUtil
                 return node;
         }
 
-        static void AttachToNode(RE::NiAVObject* obj, RE::Actor* actor, std::string nodeName)
+        static RE::NiNode* GetActorNode(RE::Actor* actor, FixedStrings::ID bone)
+        {
+            return GetActorNode(actor, FixedStrings::Get(bone));
+        }
+
+        static void AttachToNode(RE::NiAVObject* obj, RE::Actor* actor, FixedStrings::ID bone)
         {
-            auto* node = GetActorNode(actor, nodeName);
+            auto* node = GetActorNode(actor, bone);
             if (node)
             {
                 node->AttachChild(obj, true);
@@ -554,55 +641,50 @@ namespace NifUtil
     {
         static bool ToggleMeshCollision(RE::NiAVObject* root,RE::bhkWorld* world, bool collisionState)
         {
-            constexpr auto no_collision_flag = static_cast<std::uint32_t>(RE::CFilter::Flag::kNoCollision);
-					if (root && world) {
-						
-							RE::BSWriteLockGuard locker(world->worldLock);
-
-							RE::BSVisit::TraverseScenegraphCollision(root, [&](RE::bhkNiCollisionObject* a_col) -> RE::BSVisit::BSVisitControl {
-								if (auto hkpBody = a_col->body ? static_cast<RE::hkpWorldObject*>(a_col->body->referencedObject.get()) : nullptr; hkpBody) {
-									auto& filter = hkpBody->collidable.broadPhaseHandle.collisionFilterInfo;
-									if (!collisionState) {
-										filter |= no_collision_flag;
-									} else {
-										filter &= ~no_collision_flag;
-									}
-								}
-								return RE::BSVisit::BSVisitControl::kContinue;
-							});
-					}
-                    else 
-                    {
-                        return false;
-                    }
+            if (!root || !world) {
+                return false;
+            }
+
+            ToggleMeshCollision(std::span(&root, 1), world, collisionState);
             return true;
         }
-         static bool RemoveMeshCollision(RE::NiAVObject* root,RE::bhkWorld* world, bool collisionState)
+
+        // Updates every root under a single acquisition of the world lock, so toggling a group costs
+        // one lock round trip instead of one per actor. Returns how many bodies actually changed.
+        static std::size_t ToggleMeshCollision(std::span<RE::NiAVObject* const> roots, RE::bhkWorld* world, bool collisionState)
+        {
+            if (!world || roots.empty()) {
+                return 0;
+            }
+
+            std::size_t changed = 0;
+            RE::BSWriteLockGuard locker(world->worldLock);
+            for (auto root : roots) {
+                changed += SetCollisionState(root, collisionState);
+            }
+            return changed;
+        }
+
+        static bool RemoveMeshCollision(RE::NiAVObject* root,RE::bhkWorld* world, bool collisionState)
+        {
+            return ToggleMeshCollision(root, world, collisionState);
+        }
+
+    private:
+        // Caller holds the world lock. Bodies already in the requested state are left untouched.
+        static std::size_t SetCollisionState(RE::NiAVObject* root, bool collisionState)
         {
             constexpr auto no_collision_flag = static_cast<std::uint32_t>(RE::CFilter::Flag::kNoCollision);
-					if (root && world) {
-						
-							RE::BSWriteLockGuard locker(world->worldLock);
-
-							RE::BSVisit::TraverseScenegraphCollision(root, [&](RE::bhkNiCollisionObject* a_col) -> RE::BSVisit::BSVisitControl {
-								if (auto hkpBody = a_col->body ? static_cast<RE::hkpWorldObject*>(a_col->body->referencedObject.get()) : nullptr; hkpBody) {
-									auto& filter = hkpBody->collidable.broadPhaseHandle.collisionFilterInfo;
-									if (!collisionState) {
-										filter |= no_collision_flag;
-									} else {
-										filter &= ~no_collision_flag;
-									}
-								}
-								return RE::BSVisit::BSVisitControl::kContinue;
-							});
-					}
-                    else 
-                    {
-                        return false;
-                    }
-            return true;
+            std::size_t changed = 0;
+            Visit::Bodies(root, [&](RE::hkpWorldObject* body) {
+                auto& filter = body->collidable.broadPhaseHandle.collisionFilterInfo;
+                auto desired = collisionState ? (filter & ~no_collision_flag) : (filter | no_collision_flag);
+                if (filter != desired) {
+                    filter = desired;
+                    ++changed;
+                }
+            });
+            return changed;
         }
     };
-
-   
 }
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <memory>
+#include "class_rules.h"
+#include "thread_pool.h"
+
+// Effect profiles that weapons qualify for through their keywords or base enchantment. Which profile
+// every weapon gets is worked out once, on the thread pool, by scanning all weapon records; equipping
+// a weapon then costs one hash lookup.
+namespace CombatClasses {
+    using ProfileID = std::uint16_t;
+    inline constexpr ProfileID kNoProfile = 0xFFFF;
+
+    struct RawWeaponProfile {
+        std::string name;
+        std::vector<std::string> keywords;
+        std::vector<std::string> enchantments;
+        float accuracy = 0.0f;
+        float knockback = 0.0f;
+        float stagger = 0.0f;
+        float procChance = 1.0f;
+
+        bool operator==(const RawWeaponProfile&) const = default;
+    };
+
+    struct WeaponProfile {
+        std::string name;
+        // Marksman bonus while the weapon is drawn
+        float accuracy = 0.0f;
+        // PushActorAway magnitude against the struck enemy (or nearest, on the timer), 0 for none
+        float knockback = 0.0f;
+        // Stagger magnitude against the struck enemy (or nearest, on the timer), 0 for none
+        float stagger = 0.0f;
+        // Chance each strike, timed or on hit, actually triggers the effect
+        float procChance = 1.0f;
+
+        bool HasStrikeEffect() const { return knockback > 0.0f || stagger > 0.0f; }
+    };
+
+    class WeaponProfileTable {
+    private:
+        // Everything a worker needs to classify a weapon. Shared read-only with the scan jobs so a
+        // reload can replace it while an older scan is still running.
+        struct Matcher {
+            std::unordered_map<RE::FormID, ProfileID> byKeyword;
+            std::unordered_map<RE::FormID, ProfileID> byEnchantment;
+
+            ProfileID Classify(const RE::TESObjectWEAP* weapon) const {
+                auto best = kNoProfile;
+                for (std::uint32_t i = 0; i < weapon->numKeywords; ++i) {
+                    auto keyword = weapon->keywords[i];
+                    if (!keyword) continue;
+                    if (auto it = byKeyword.find(keyword->GetFormID()); it != byKeyword.end()) {
+                        best = std::min(best, it->second);
+                    }
+                }
+                if (auto enchantment = weapon->formEnchanting) {
+                    if (auto it = byEnchantment.find(enchantment->GetFormID()); it != byEnchantment.end()) {
+                        best = std::min(best, it->second);
+                    }
+                }
+                return best;
+            }
+        };
+
+        using ScanChunk = std::vector<std::pair<RE::FormID, ProfileID>>;
+
+        // Weapons handed to one job; large enough that scheduling is noise next to the work
+        static constexpr std::size_t minChunkSize = 1024;
+
+        std::vector<RawWeaponProfile> source;
+        std::vector<WeaponProfile> profiles;
+        std::unordered_map<RE::FormID, ProfileID> weapons;
+
+        // Bumped per scan so chunks of a superseded scan are dropped
+        std::uint32_t scanGeneration = 0;
+        std::size_t pendingChunks = 0;
+
+    public:
+        // Resolves keyword and enchantment references and rescans every weapon when the profiles
+        // changed. onScanned runs on the game thread once the new table is complete. Game thread only.
+        void Compile(const std::vector<RawWeaponProfile>& rawProfiles, std::function<void()> onScanned) {
+            if (rawProfiles == source && !profiles.empty()) {
+                return;
+            }
+
+            source = rawProfiles;
+            profiles.clear();
+            weapons.clear();
+            ++scanGeneration;
+            pendingChunks = 0;
+
+            if (source.empty()) {
+                return;
+            }
+
+            auto matcher = std::make_shared<Matcher>();
+            for (const auto& raw : source) {
+                auto id = static_cast<ProfileID>(profiles.size());
+                profiles.push_back({ raw.name, raw.accuracy, raw.knockback, raw.stagger, std::clamp(raw.procChance, 0.0f, 1.0f) });
+
+                auto resolveInto = [&](const std::vector<std::string>& references, std::unordered_map<RE::FormID, ProfileID>& target, RE::FormType formType) {
+                    for (const auto& reference : references) {
+                        auto form = ResolveFormReference(reference);
+                        if (!form || form->GetFormType() != formType) {
+                            logger::warn("Weapon profile {}: could not resolve '{}'", raw.name, reference);
+                            continue;
+                        }
+                        // Earlier profiles win, so keep the first id seen for a form
+                        target.try_emplace(form->GetFormID(), id);
+                    }
+                };
+                resolveInto(raw.keywords, matcher->byKeyword, RE::FormType::Keyword);
+                resolveInto(raw.enchantments, matcher->byEnchantment, RE::FormType::Enchantment);
+            }
+
+            Scan(std::move(matcher), std::move(onScanned));
+        }
+
+        ProfileID FindID(RE::FormID weaponID) const {
+            auto it = weapons.find(weaponID);
+            return it != weapons.end() ? it->second : kNoProfile;
+        }
+
+        const WeaponProfile* GetProfile(ProfileID id) const {
+            return id < profiles.size() ? &profiles[id] : nullptr;
+        }
+
+        // Calls visit(weaponID, profile) for every weapon matched so far
+        template <class Visitor>
+        void ForEachWeapon(Visitor&& visit) const {
+            for (const auto& [weaponID, id] : weapons) {
+                visit(weaponID, profiles[id]);
+            }
+        }
+
+    private:
+        void Scan(std::shared_ptr<const Matcher> matcher, std::function<void()> onScanned) {
+            auto dataHandler = RE::TESDataHandler::GetSingleton();
+            if (!dataHandler) {
+                return;
+            }
+
+            // Weapon records are immutable once data has loaded, so workers can read them directly
+            const auto& allWeapons = dataHandler->GetFormArray<RE::TESObjectWEAP>();
+            std::span<RE::TESObjectWEAP* const> records(allWeapons.data(), allWeapons.size());
+            if (records.empty()) {
+                return;
+            }
+
+            auto chunkCount = std::clamp<std::size_t>(records.size() / minChunkSize, 1, ThreadPool::GetDefaultWorkerCount());
+            auto chunkSize = (records.size() + chunkCount - 1) / chunkCount;
+            auto generation = scanGeneration;
+            auto started = std::chrono::steady_clock::now();
+            auto shared = std::make_shared<std::function<void()>>(std::move(onScanned));
+
+            pendingChunks = (records.size() + chunkSize - 1) / chunkSize;
+            for (std::size_t first = 0; first < records.size(); first += chunkSize) {
+                auto chunk = records.subspan(first, std::min(chunkSize, records.size() - first));
+                ThreadPool::GetSingleton()->Submit(
+                    [matcher, chunk] {
+                        ScanChunk matches;
+                        for (auto weapon : chunk) {
+                            if (!weapon) continue;
+                            if (auto id = matcher->Classify(weapon); id != kNoProfile) {
+                                matches.emplace_back(weapon->GetFormID(), id);
+                            }
+                        }
+                        return matches;
+                    },
+                    [this, generation, started, shared, total = records.size()](ScanChunk&& matches) {
+                        if (generation != scanGeneration) {
+                            return;
+                        }
+                        weapons.insert(matches.begin(), matches.end());
+                        if (--pendingChunks > 0) {
+                            return;
+                        }
+
+                        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+                        logger::info("Scanned {} weapons in {}us, {} have an effect profile", total, elapsed.count(), weapons.size());
+                        if (*shared) {
+                            (*shared)();
+                        }
+                    });
+            }
+        }
+    };
+}
@@ -0,0 +1,143 @@
+#include <random>
+#include "actor_roster.h"
+#include "check.h"
+
+constexpr RE::FormID lydia = 0x000A2C94;
+constexpr RE::FormID serana = 0x02002B74;
+constexpr RE::FormID bandit = 0xFF000801;
+
+// PeriodicUpdateTask's scheduling around the roster, with SKSE's task queue reduced to a flag: combat
+// starts the update through StartTicking, and each queued frame asks ContinueTicking before it ticks.
+struct UpdateLoop {
+    ActorRoster<int> roster;
+    bool queued = false;
+    std::uint64_t ticks = 0;
+    std::uint64_t ticksWithNobodyFighting = 0;
+
+    void OnCombatStateChanged(RE::FormID formID, bool inCombat) {
+        if (inCombat) {
+            if (roster.EnterCombat(formID, 0) && roster.StartTicking()) {
+                queued = true;
+            }
+        } else {
+            roster.LeaveCombat(formID);
+        }
+    }
+
+    void Frame() {
+        if (!queued) {
+            return;
+        }
+        queued = false;
+        if (!roster.ContinueTicking()) {
+            return;
+        }
+        ++ticks;
+        ticksWithNobodyFighting += roster.GetFighting().empty();
+        queued = true;
+    }
+};
+
+static void TestGating() {
+    UpdateLoop loop;
+    loop.roster.Register(lydia);
+    loop.roster.Register(serana);
+    loop.roster.Load(lydia, 1);
+
+    // Outsiders fighting never start the update
+    loop.OnCombatStateChanged(bandit, true);
+    for (int i = 0; i < 10; ++i) {
+        loop.Frame();
+    }
+    CHECK_EQ(loop.ticks, 0u);
+    CHECK(!loop.roster.IsTicking());
+
+    // One tick per frame while a follower fights, however many join
+    loop.OnCombatStateChanged(lydia, true);
+    loop.OnCombatStateChanged(serana, true);
+    loop.OnCombatStateChanged(lydia, true);
+    for (int i = 0; i < 10; ++i) {
+        loop.Frame();
+    }
+    CHECK_EQ(loop.ticks, 10u);
+
+    // The frame after the last one leaves, the update ends and stays off
+    loop.OnCombatStateChanged(lydia, false);
+    loop.Frame();
+    CHECK_EQ(loop.ticks, 11u);
+    loop.OnCombatStateChanged(serana, false);
+    for (int i = 0; i < 10; ++i) {
+        loop.Frame();
+    }
+    CHECK_EQ(loop.ticks, 11u);
+    CHECK(!loop.roster.IsTicking());
+    CHECK(!loop.queued);
+
+    // Unloading or unregistering a fighter takes it out of the fight, and so does a load
+    loop.OnCombatStateChanged(lydia, true);
+    CHECK(loop.queued);
+    CHECK(loop.roster.Unload(lydia).value_or(0) == 1);
+    loop.Frame();
+    CHECK_EQ(loop.ticks, 11u);
+
+    loop.OnCombatStateChanged(serana, true);
+    CHECK(loop.roster.Unregister(serana));
+    loop.roster.Unload(serana);
+    loop.Frame();
+    loop.OnCombatStateChanged(serana, true);
+    loop.Frame();
+    CHECK_EQ(loop.ticks, 11u);
+
+    loop.OnCombatStateChanged(lydia, true);
+    loop.roster.Reset();
+    loop.Frame();
+    CHECK_EQ(loop.ticks, 11u);
+    CHECK(loop.roster.IsRegistered(lydia));
+    CHECK(!loop.roster.FindLoaded(lydia));
+}
+
+// Random fights over many frames: the update ticks on exactly the frames where a follower fights
+static void TestRandomFights() {
+    UpdateLoop loop;
+    std::array<RE::FormID, 4> followers{ lydia, serana, 0x0001A697, 0x000B9986 };
+    for (auto formID : followers) {
+        loop.roster.Register(formID);
+        loop.roster.Load(formID, 0);
+    }
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> pickActor(0, 5);
+    std::uniform_int_distribution<int> pickEvent(0, 99);
+    std::uint64_t framesWithFighters = 0;
+    for (int frame = 0; frame < 100000; ++frame) {
+        auto roll = pickEvent(random);
+        auto actor = pickActor(random);
+        auto formID = actor < 4 ? followers[actor] : bandit + actor;
+        if (roll < 4) {
+            loop.OnCombatStateChanged(formID, true);
+        } else if (roll < 9) {
+            loop.OnCombatStateChanged(formID, false);
+        } else if (roll < 10) {
+            loop.roster.Unload(formID);
+            loop.roster.Load(formID, 0);
+        }
+
+        bool fighting = !loop.roster.GetFighting().empty();
+        framesWithFighters += fighting;
+        auto ticksBefore = loop.ticks;
+        loop.Frame();
+        CHECK_EQ(loop.ticks - ticksBefore, fighting ? 1u : 0u);
+        if (!fighting) {
+            CHECK(!loop.queued && !loop.roster.IsTicking());
+        }
+    }
+    CHECK_EQ(loop.ticksWithNobodyFighting, 0u);
+    CHECK_EQ(loop.ticks, framesWithFighters);
+    CHECK(framesWithFighters > 0 && framesWithFighters < 100000);
+}
+
+int main() {
+    TestGating();
+    TestRandomFights();
+    return Check::Failures();
+}
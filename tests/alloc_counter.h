@@ -0,0 +1,24 @@
+#pragma once
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts every global allocation so a test can prove a path stays off the heap.
+// Replaces operator new for the whole executable; include it from exactly one file.
+namespace AllocCounter {
+    inline std::atomic<std::uint64_t> allocations{ 0 };
+
+    inline std::uint64_t Count() { return allocations.load(std::memory_order_relaxed); }
+}
+
+void* operator new(std::size_t size) {
+    AllocCounter::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
@@ -0,0 +1,70 @@
+#include "assignment.h"
+#include "check.h"
+
+using CombatClasses::AssignGreedy;
+using CombatClasses::kForbiddenCost;
+using CombatClasses::kUnassigned;
+
+constexpr float crowding = 768.0f;
+using Costs = std::array<std::array<float, 4>, 4>;
+
+static std::array<std::uint8_t, 4> Assign(const Costs& costs, std::size_t rows, std::size_t columns, std::array<std::uint8_t, 4> previous = { kUnassigned, kUnassigned, kUnassigned, kUnassigned }) {
+    AssignGreedy(costs, columns, crowding, std::span(previous.data(), rows));
+    return previous;
+}
+
+static void TestSpreads() {
+    // Both prefer enemy 0, but a second follower there costs more than going to enemy 1
+    Costs costs{};
+    costs[0] = { 100.0f, 900.0f };
+    costs[1] = { 110.0f, 300.0f };
+    auto assigned = Assign(costs, 2, 2);
+    CHECK_EQ(assigned[0], 0);
+    CHECK_EQ(assigned[1], 1);
+
+    // Unless the other enemy is far enough away that doubling up is still cheaper
+    costs[1] = { 110.0f, 5000.0f };
+    assigned = Assign(costs, 2, 2);
+    CHECK_EQ(assigned[0], 0);
+    CHECK_EQ(assigned[1], 0);
+}
+
+static void TestForbiddenPairs() {
+    // Follower 0's cheapest enemy isn't hostile to it, so it goes elsewhere
+    Costs costs{};
+    costs[0] = { kForbiddenCost, 2000.0f };
+    costs[1] = { 300.0f, 400.0f };
+    auto assigned = Assign(costs, 2, 2);
+    CHECK_EQ(assigned[0], 1);
+    CHECK_EQ(assigned[1], 0);
+
+    // No enemy is hostile to follower 2, so it gets nothing, while the others are still assigned
+    costs[2] = { kForbiddenCost, kForbiddenCost };
+    assigned = Assign(costs, 3, 2, { 0, 1, 1, kUnassigned });
+    CHECK_EQ(assigned[0], 1);
+    CHECK_EQ(assigned[1], 0);
+    CHECK_EQ(assigned[2], kUnassigned);
+}
+
+static void TestTiesKeepPrevious() {
+    Costs costs{};
+    costs[0] = { 300.0f, 300.0f };
+    CHECK_EQ(Assign(costs, 1, 2, { 1 })[0], 1);
+    CHECK_EQ(Assign(costs, 1, 2, { 0 })[0], 0);
+}
+
+static void TestNoEnemies() {
+    Costs costs{};
+    auto assigned = Assign(costs, 3, 0, { 0, 1, 2, kUnassigned });
+    CHECK_EQ(assigned[0], kUnassigned);
+    CHECK_EQ(assigned[1], kUnassigned);
+    CHECK_EQ(assigned[2], kUnassigned);
+}
+
+int main() {
+    TestSpreads();
+    TestForbiddenPairs();
+    TestTiesKeepPrevious();
+    TestNoEnemies();
+    return Check::Failures();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal assertions for the host tests. A failed CHECK prints where and keeps going so one run
+// reports every broken expectation; main returns Failures() to let CTest see the result.
+namespace Check {
+    inline int failures = 0;
+
+    inline int Failures() {
+        if (failures) {
+            std::fprintf(stderr, "%d check(s) failed\n", failures);
+        }
+        return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+}
+
+#define CHECK(condition)                                                                        \
+    do {                                                                                        \
+        if (!(condition)) {                                                                     \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++Check::failures;                                                                  \
+        }                                                                                       \
+    } while (false)
+
+#define CHECK_EQ(actual, expected) CHECK((actual) == (expected))
@@ -0,0 +1,176 @@
+#include <random>
+#include "check.h"
+#include "rule_matcher.h"
+
+// Class rules at load order scale: compiles a config's worth of rules, then matches populations of
+// synthetic actors the way RuleTable reads them from the game (base factions, race and keywords, then
+// level and drawn weapon). Every result is checked against the rules evaluated one predicate at a time.
+using namespace std::chrono;
+using namespace CombatClasses;
+
+enum class Drawn : std::uint8_t {
+    kNothing,
+    kBow,
+    kOneHanded,
+    kTwoHanded
+};
+
+struct SyntheticActor {
+    std::vector<RE::FormID> factions;
+    RE::FormID race;
+    std::vector<RE::FormID> keywords;
+    std::uint16_t level;
+    Drawn drawn;
+};
+
+// MatchesWeapon with the weapon type already read off the drawn weapon
+static bool Matches(WeaponCondition condition, Drawn drawn) {
+    switch (drawn) {
+    case Drawn::kBow:
+        return condition == WeaponCondition::kAny || condition == WeaponCondition::kBow;
+    case Drawn::kOneHanded:
+        return condition == WeaponCondition::kAny || condition == WeaponCondition::kMelee || condition == WeaponCondition::kOneHanded;
+    case Drawn::kTwoHanded:
+        return condition == WeaponCondition::kAny || condition == WeaponCondition::kMelee || condition == WeaponCondition::kTwoHanded;
+    default:
+        return condition == WeaponCondition::kAny;
+    }
+}
+
+// RuleTable::EvaluateBase and EvaluateReference over the synthetic actor
+static ClassID Match(const RuleMatcher& matcher, const SyntheticActor& actor) {
+    RuleBits bits;
+    if (matcher.UsesFactions()) {
+        for (auto faction : actor.factions) {
+            matcher.AddFaction(bits, faction);
+        }
+    }
+    if (matcher.UsesRaces()) {
+        matcher.AddRace(bits, actor.race);
+    }
+    if (matcher.UsesKeywords()) {
+        for (auto keyword : actor.keywords) {
+            matcher.AddKeyword(bits, keyword);
+        }
+    }
+    if (matcher.UsesLevels()) {
+        matcher.AddLevel(bits, actor.level);
+    }
+    if (matcher.UsesWeapons()) {
+        matcher.AddWeapon(bits, [&](WeaponCondition condition) { return Matches(condition, actor.drawn); });
+    }
+    return matcher.Match(bits);
+}
+
+static ClassID MatchOneByOne(const std::vector<ResolvedRule>& rules, const SyntheticActor& actor) {
+    auto anyOf = [](const std::vector<RE::FormID>& wanted, std::span<const RE::FormID> held) {
+        return wanted.empty() || std::ranges::any_of(held, [&](RE::FormID formID) { return std::ranges::find(wanted, formID) != wanted.end(); });
+    };
+    for (const auto& rule : rules) {
+        auto maxLevel = rule.maxLevel > 0 ? rule.maxLevel : UINT16_MAX;
+        if (anyOf(rule.factions, actor.factions) && anyOf(rule.races, { &actor.race, 1 }) && anyOf(rule.keywords, actor.keywords) &&
+            actor.level >= rule.minLevel && actor.level <= maxLevel && (!rule.weapon || Matches(*rule.weapon, actor.drawn))) {
+            return rule.classID;
+        }
+    }
+    return kNoClass;
+}
+
+int main() {
+    std::mt19937 random(99);
+
+    // Forms the rules pick from: vanilla and mod factions, the playable and creature races, NPC keywords
+    std::vector<RE::FormID> factions, races, keywords;
+    for (RE::FormID i = 0; i < 400; ++i) {
+        factions.push_back(0x00028000 + i * 3);
+    }
+    for (RE::FormID i = 0; i < 40; ++i) {
+        races.push_back(0x00013740 + i);
+    }
+    for (RE::FormID i = 0; i < 120; ++i) {
+        keywords.push_back(0x0001D000 + i * 5);
+    }
+
+    auto pickFrom = [&](const std::vector<RE::FormID>& forms, std::size_t count) {
+        std::vector<RE::FormID> picked;
+        std::uniform_int_distribution<std::size_t> pick(0, forms.size() - 1);
+        for (std::size_t i = 0; i < count; ++i) {
+            picked.push_back(forms[pick(random)]);
+        }
+        return picked;
+    };
+
+    // Sixty rules: most narrow down by faction and more, the last few are catch-alls by race
+    std::vector<std::string> names;
+    for (int i = 0; i < 60; ++i) {
+        names.push_back(fmt::format("Rule{}", i));
+    }
+    std::vector<ResolvedRule> rules;
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<int> pickCondition(0, 4);
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        ResolvedRule rule;
+        rule.name = names[i];
+        rule.classID = static_cast<ClassID>(i % 12);
+        bool catchAll = i >= 54;
+        if (!catchAll) rule.factions = pickFrom(factions, 1 + roll(random) % 6);
+        if (catchAll || roll(random) < 40) rule.races = pickFrom(races, 1 + roll(random) % 4);
+        if (!catchAll && roll(random) < 40) rule.keywords = pickFrom(keywords, 1 + roll(random) % 3);
+        if (!catchAll && roll(random) < 30) {
+            rule.minLevel = static_cast<std::uint16_t>(roll(random) % 30);
+            rule.maxLevel = roll(random) < 50 ? static_cast<std::uint16_t>(rule.minLevel + 10 + roll(random) % 40) : 0;
+        }
+        if (roll(random) < 30) rule.weapon = static_cast<WeaponCondition>(pickCondition(random));
+        rules.push_back(std::move(rule));
+    }
+
+    RuleMatcher matcher;
+    auto compileTime = nanoseconds::max();
+    for (int run = 0; run < 5; ++run) {
+        auto started = steady_clock::now();
+        matcher.Clear();
+        for (const auto& rule : rules) {
+            CHECK(matcher.Add(rule));
+        }
+        compileTime = std::min(compileTime, duration_cast<nanoseconds>(steady_clock::now() - started));
+    }
+    CHECK_EQ(matcher.size(), rules.size());
+    CHECK(matcher.atoms() <= kMaxRuleAtoms);
+    std::printf("%zu rules over %zu predicates compiled in %.1fus\n", matcher.size(), matcher.atoms(),
+        static_cast<double>(compileTime.count()) / 1000.0);
+
+    std::uniform_int_distribution<int> pickLevel(1, 81);
+    std::uniform_int_distribution<int> pickDrawn(0, 3);
+    for (std::size_t count : { 1'000u, 10'000u, 100'000u }) {
+        std::vector<SyntheticActor> actors(count);
+        for (auto& actor : actors) {
+            actor.factions = pickFrom(factions, 2 + roll(random) % 10);
+            actor.race = pickFrom(races, 1)[0];
+            actor.keywords = pickFrom(keywords, roll(random) % 8);
+            actor.level = static_cast<std::uint16_t>(pickLevel(random));
+            actor.drawn = static_cast<Drawn>(pickDrawn(random));
+        }
+
+        std::vector<ClassID> matched(count);
+        auto best = nanoseconds::max();
+        for (int run = 0; run < 3; ++run) {
+            auto started = steady_clock::now();
+            for (std::size_t i = 0; i < count; ++i) {
+                matched[i] = Match(matcher, actors[i]);
+            }
+            best = std::min(best, duration_cast<nanoseconds>(steady_clock::now() - started));
+        }
+
+        std::size_t classed = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            CHECK_EQ(matched[i], MatchOneByOne(rules, actors[i]));
+            classed += matched[i] != kNoClass;
+        }
+        // Both outcomes have to be exercised for the comparison to mean anything
+        CHECK(classed > 0 && classed < count);
+
+        std::printf("%zu actors: %.1fns/actor, %zu classed\n", count, static_cast<double>(best.count()) / count, classed);
+    }
+
+    return Check::Failures();
+}
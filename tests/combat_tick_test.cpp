@@ -0,0 +1,129 @@
+#include <random>
+#include "actor_roster.h"
+#include "alloc_counter.h"
+#include "assignment.h"
+#include "check.h"
+#include "fixed_containers.h"
+#include "timing_wheel.h"
+
+// The storage a combat tick goes through, driven frame by frame the way PeriodicUpdateTask::Tick drives
+// it: the roster's gating and fighter list, target assignment over the cost matrix, line of sight pairs
+// and idle cooldowns coming and going in their fixed maps, and strike timers rescheduling themselves on
+// the timing wheel. The engine calls in between need a game, but everything a tick keeps lives in these,
+// so once the first frames have sized them a tick must not allocate.
+using namespace std::chrono;
+
+constexpr std::size_t followerCount = 4;
+constexpr std::size_t enemyCount = 40;
+constexpr std::size_t maxEnemies = 64;
+
+struct Fight {
+    ActorRoster<int> roster;
+    Timers::TimingWheel wheel;
+    FixedMap<std::uint64_t, std::uint32_t, 1024> lineOfSight;  // pair -> frame it was checked
+    FixedMap<RE::FormID, std::uint32_t, 128> cooldowns;        // actor -> frame the cooldown ends
+    std::array<std::array<float, maxEnemies>, 16> costs{};
+    std::array<std::uint8_t, followerCount> assigned{};
+    std::array<RE::FormID, enemyCount> enemies{};
+    std::uint32_t frame = 0;
+    std::uint64_t strikes = 0;
+    std::mt19937 random{ 5 };
+
+    Fight() {
+        for (RE::FormID i = 0; i < followerCount; ++i) {
+            roster.Register(0x0001A690 + i);
+            roster.Load(0x0001A690 + i, 0);
+            roster.EnterCombat(0x0001A690 + i, 0);
+            ScheduleStrike(i);
+        }
+        roster.StartTicking();
+        for (std::size_t j = 0; j < enemyCount; ++j) {
+            enemies[j] = 0xFF000800 + static_cast<RE::FormID>(j);
+        }
+        assigned.fill(CombatClasses::kUnassigned);
+    }
+
+    // A strike every 10 game seconds per follower, each one scheduling the next like the knockback timer
+    void ScheduleStrike(std::size_t follower) {
+        wheel.Schedule(10s, [fight = this, follower] {
+            ++fight->strikes;
+            fight->ScheduleStrike(follower);
+        });
+    }
+
+    void Tick() {
+        ++frame;
+        CHECK(roster.ContinueTicking());
+
+        FixedVector<RE::FormID, 16> fighters;
+        for (const auto& tracked : roster.GetFighting()) {
+            fighters.push_back(tracked.formID);
+        }
+
+        // Enemies die and reinforcements arrive under new form IDs
+        if (frame % 50 == 0) {
+            enemies[random() % enemyCount] = 0xFF001000 + frame;
+        }
+
+        std::uniform_real_distribution<float> distance(0.0f, 4096.0f);
+        for (std::size_t i = 0; i < fighters.size(); ++i) {
+            for (std::size_t j = 0; j < enemyCount; ++j) {
+                costs[i][j] = distance(random);
+            }
+        }
+        CombatClasses::AssignGreedy(costs, enemyCount, 768.0f, std::span(assigned.data(), fighters.size()));
+
+        // Two archers ask about every enemy; answers age out after a second
+        for (std::size_t i = 0; i < 2; ++i) {
+            for (auto enemy : enemies) {
+                auto key = (static_cast<std::uint64_t>(fighters[i]) << 32) | enemy;
+                if (auto checked = lineOfSight.try_emplace(key); checked && frame - *checked > 30) {
+                    *checked = frame;
+                }
+            }
+        }
+        lineOfSight.erase_if([this](std::uint64_t, std::uint32_t checked) { return frame - checked > 120; });
+
+        // A few staggers a second, each putting its target on a half second cooldown
+        if (frame % 7 == 0) {
+            auto target = enemies[random() % enemyCount];
+            if (!cooldowns.contains(target)) {
+                if (auto until = cooldowns.try_emplace(target)) {
+                    *until = frame + 30;
+                }
+            }
+        }
+        cooldowns.erase_if([this](RE::FormID, std::uint32_t until) { return until <= frame; });
+
+        wheel.Advance(microseconds(16667));
+    }
+};
+
+static void TestSteadyStateTick() {
+    auto fight = std::make_unique<Fight>();
+
+    // The first frames grow the timer storage
+    for (int i = 0; i < 1200; ++i) {
+        fight->Tick();
+    }
+
+    auto allocationsBefore = AllocCounter::Count();
+    auto started = steady_clock::now();
+    constexpr int frames = 20000;
+    for (int i = 0; i < frames; ++i) {
+        fight->Tick();
+    }
+    auto elapsed = steady_clock::now() - started;
+    CHECK_EQ(AllocCounter::Count() - allocationsBefore, 0u);
+    CHECK(fight->strikes > 0);
+    CHECK(!fight->lineOfSight.empty());
+
+    std::printf("%d combat ticks: %.0fns per tick, %llu strikes, %zu line of sight pairs, %zu cooldowns\n", frames,
+        static_cast<double>(duration_cast<nanoseconds>(elapsed).count()) / frames, static_cast<unsigned long long>(fight->strikes),
+        fight->lineOfSight.size(), fight->cooldowns.size());
+}
+
+int main() {
+    TestSteadyStateTick();
+    return Check::Failures();
+}
@@ -0,0 +1,103 @@
+#include <thread>
+#include "check.h"
+#include "event_log.h"
+
+using EventLog::Record;
+using EventLog::RecordType;
+
+static void TestVarint() {
+    const std::array<std::uint64_t, 8> values{ 0, 1, 127, 128, 300, 0xFFFFFFFFull, 1ull << 63, UINT64_MAX };
+
+    std::vector<std::uint8_t> bytes;
+    for (auto value : values) {
+        EventLog::WriteVarint(bytes, value);
+    }
+    // 1 + 1 + 1 + 2 + 2 + 5 + 10 + 10
+    CHECK_EQ(bytes.size(), 32u);
+
+    std::span<const std::uint8_t> in(bytes);
+    for (auto expected : values) {
+        std::uint64_t value = 0;
+        CHECK(EventLog::ReadVarint(in, value));
+        CHECK_EQ(value, expected);
+    }
+    CHECK(in.empty());
+
+    // A continuation byte with nothing after it is not a value
+    std::vector<std::uint8_t> cut{ 0x80 };
+    std::span<const std::uint8_t> truncated(cut);
+    std::uint64_t value = 0;
+    CHECK(!EventLog::ReadVarint(truncated, value));
+}
+
+// The recorder hands chunks to the thread pool, so the file is complete once the close job ran
+static std::optional<std::vector<Record>> WaitForRecords(const std::filesystem::path& path, std::size_t count) {
+    for (int attempt = 0; attempt < 500; ++attempt) {
+        if (auto records = EventLog::ReadFile(path); records && records->size() == count) {
+            return records;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return EventLog::ReadFile(path);
+}
+
+static void TestRecorder() {
+    auto path = std::filesystem::temp_directory_path() / "cs_event_log_test.bin";
+    auto recorder = EventLog::Recorder::GetSingleton();
+
+    CHECK(recorder->Start(path));
+    CHECK(!recorder->Start(path));
+    CHECK(recorder->IsRecording());
+
+    // Enough records to cross the flush threshold a few times
+    constexpr std::uint32_t count = 40000;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        recorder->Record(static_cast<RecordType>(i % static_cast<std::uint32_t>(RecordType::kTypeCount)), 0x14 + i, 0xFF000800u + i, i & 1, i % 9 == 8 ? 0x0001397Eu : 0);
+    }
+    recorder->Stop();
+    CHECK(!recorder->IsRecording());
+
+    auto records = WaitForRecords(path, count);
+    CHECK(records.has_value());
+    if (!records) {
+        return;
+    }
+    CHECK_EQ(records->size(), count);
+
+    bool matches = true;
+    std::uint64_t lastTimestamp = 0;
+    for (std::uint32_t i = 0; i < records->size(); ++i) {
+        const auto& record = (*records)[i];
+        matches &= record.type == static_cast<RecordType>(i % static_cast<std::uint32_t>(RecordType::kTypeCount));
+        matches &= record.first == 0x14 + i && record.second == 0xFF000800u + i && record.flag == (i & 1);
+        matches &= record.third == (i % 9 == 8 ? 0x0001397Eu : 0);
+        matches &= record.timestampUs >= lastTimestamp;
+        lastTimestamp = record.timestampUs;
+    }
+    CHECK(matches);
+
+    // A crash mid-write leaves a partial record; everything before it still reads
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 2);
+    auto truncated = EventLog::ReadFile(path);
+    CHECK(truncated && truncated->size() == count - 1);
+
+    // Wrong version or not a log at all
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(4);
+        std::uint16_t otherVersion = EventLog::version + 1;
+        file.write(reinterpret_cast<const char*>(&otherVersion), 2);
+    }
+    CHECK(!EventLog::ReadFile(path));
+    CHECK(!EventLog::ReadFile(path.string() + ".missing"));
+
+    std::filesystem::remove(path);
+}
+
+int main() {
+    TestVarint();
+    TestRecorder();
+    ThreadPool::GetSingleton()->Shutdown();
+    return Check::Failures();
+}
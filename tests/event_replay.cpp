@@ -0,0 +1,34 @@
+// Replays an event log recorded in game through the follower roster and prints the summary, with the
+// heap allocations each kind of event made.
+//
+//   event_replay <path to CS_CombatClasses_events.bin>
+#include "alloc_counter.h"
+#include "event_replay.h"
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fmt::print(stderr, "usage: {} <event log>\n", argv[0]);
+        return 2;
+    }
+
+    auto records = EventLog::ReadFile(argv[1]);
+    if (!records) {
+        fmt::print(stderr, "{} is missing or not a version {} event log\n", argv[1], EventLog::version);
+        return 1;
+    }
+
+    auto result = EventLog::Replay(*records, AllocCounter::Count);
+    fmt::print("{} events in {}us (recorded over {}us)\n", records->size(),
+        std::chrono::duration_cast<std::chrono::microseconds>(result.elapsed).count(), result.recordedUs);
+    for (std::size_t i = 0; i < result.stats.size(); ++i) {
+        const auto& stats = result.stats[i];
+        if (stats.count) {
+            fmt::print("  {:<16} {:>8} events, avg {:>6}ns, max {:>8}ns, {:>6} allocations\n", EventLog::recordTypeNames[i], stats.count,
+                stats.total.count() / static_cast<std::int64_t>(stats.count), stats.max.count(), stats.allocations);
+        }
+    }
+    fmt::print("party hits {}, party wounds {}, most fighting at once {}\n", result.partyHits, result.partyWounds, result.maxFighters);
+    fmt::print("ticks with nobody fighting {}, ticks disagreeing with the fighter count {}\n", result.ticksOutsideCombat, result.tickMismatches);
+
+    return result.ticksOutsideCombat || result.tickMismatches ? 1 : 0;
+}
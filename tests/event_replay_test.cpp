@@ -0,0 +1,119 @@
+#include "alloc_counter.h"
+#include "check.h"
+#include "event_replay.h"
+
+using EventLog::Record;
+using EventLog::RecordType;
+
+constexpr RE::FormID lydia = 0x000A2C94;
+constexpr RE::FormID serana = 0x02002B74;
+constexpr RE::FormID bandit = 0xFF000801;
+constexpr std::uint32_t kCombat = 1;
+constexpr std::uint32_t kSearching = 2;
+
+static Record Make(RecordType type, RE::FormID first = 0, RE::FormID second = 0, std::uint32_t flag = 0) {
+    return { type, 0, first, second, 0, flag };
+}
+
+static void TestTracksTheSinks() {
+    std::vector<Record> records{
+        Make(RecordType::kRegister, lydia, 0, 1),
+        Make(RecordType::kRegister, serana, 0, 1),
+        Make(RecordType::kObjectLoaded, lydia, 0, 1),
+        Make(RecordType::kObjectLoaded, serana, 0, 1),
+        // Outsiders fight all the time; they never start the update
+        Make(RecordType::kCombat, bandit, lydia, kCombat),
+        Make(RecordType::kCombat, lydia, bandit, kCombat),
+        Make(RecordType::kTick, 1),
+        Make(RecordType::kCombat, serana, bandit, kSearching),
+        Make(RecordType::kTick, 2),
+        Make(RecordType::kHit, bandit, lydia),
+        Make(RecordType::kHit, serana, bandit),
+        Make(RecordType::kHit, bandit, 0x00000014),
+        Make(RecordType::kCellAttachDetach, serana, 0, 0),
+        Make(RecordType::kTick, 1),
+        Make(RecordType::kCombat, lydia, 0, 0),
+    };
+
+    auto result = EventLog::Replay(records);
+    CHECK_EQ(result.ticksOutsideCombat, 0u);
+    CHECK_EQ(result.tickMismatches, 0u);
+    CHECK_EQ(result.partyHits, 1u);
+    CHECK_EQ(result.partyWounds, 1u);
+    CHECK_EQ(result.maxFighters, 2u);
+    CHECK_EQ(result.stats[static_cast<std::size_t>(RecordType::kTick)].count, 3u);
+}
+
+// A tick after the last follower left the fight means the update failed to stop
+static void TestFlagsTicksOutsideCombat() {
+    std::vector<Record> records{
+        Make(RecordType::kRegister, lydia, 0, 1),
+        Make(RecordType::kCombat, lydia, bandit, kCombat),
+        Make(RecordType::kTick, 1),
+        Make(RecordType::kCombat, lydia, 0, 0),
+        Make(RecordType::kTick, 0),
+        Make(RecordType::kTick, 0),
+    };
+    auto result = EventLog::Replay(records);
+    CHECK_EQ(result.ticksOutsideCombat, 2u);
+    CHECK_EQ(result.tickMismatches, 0u);
+
+    // Deleting or unregistering a fighter takes it out of the fight, and a load forgets everyone
+    records = {
+        Make(RecordType::kRegister, lydia, 0, 1),
+        Make(RecordType::kRegister, serana, 0, 1),
+        Make(RecordType::kCombat, lydia, bandit, kCombat),
+        Make(RecordType::kCombat, serana, bandit, kCombat),
+        Make(RecordType::kFormDelete, lydia),
+        Make(RecordType::kTick, 1),
+        Make(RecordType::kCombat, lydia, bandit, kCombat),
+        Make(RecordType::kTick, 1),
+        Make(RecordType::kLoadGame),
+        Make(RecordType::kTick, 1),
+    };
+    result = EventLog::Replay(records);
+    CHECK_EQ(result.ticksOutsideCombat, 1u);
+    CHECK_EQ(result.tickMismatches, 1u);
+}
+
+// The recorder's output read back and replayed, the same way the in-game function does it
+static void TestRecordedLog() {
+    auto path = std::filesystem::temp_directory_path() / "cs_event_replay_test.bin";
+    auto recorder = EventLog::Recorder::GetSingleton();
+    CHECK(recorder->Start(path));
+    recorder->Record(RecordType::kRegister, lydia, 0, 1);
+    recorder->Record(RecordType::kCombat, lydia, bandit, kCombat);
+    for (int i = 0; i < 1000; ++i) {
+        recorder->Record(RecordType::kHit, bandit, lydia, 0, 0x0001397E);
+        recorder->Record(RecordType::kTick, 1);
+    }
+    recorder->Record(RecordType::kCombat, lydia, 0, 0);
+    recorder->Stop();
+
+    std::optional<std::vector<Record>> records;
+    for (int attempt = 0; attempt < 500 && (!records || records->size() != 2003); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        records = EventLog::ReadFile(path);
+    }
+    CHECK(records && records->size() == 2003);
+    if (records) {
+        auto result = EventLog::Replay(*records, AllocCounter::Count);
+        CHECK_EQ(result.partyHits, 1000u);
+        CHECK_EQ(result.ticksOutsideCombat, 0u);
+        CHECK_EQ(result.tickMismatches, 0u);
+
+        // The roster grows once when the fight starts; hits and ticks never touch the heap
+        CHECK(result.countedAllocations);
+        CHECK_EQ(result.stats[static_cast<std::size_t>(RecordType::kHit)].allocations, 0u);
+        CHECK_EQ(result.stats[static_cast<std::size_t>(RecordType::kTick)].allocations, 0u);
+    }
+    std::filesystem::remove(path);
+}
+
+int main() {
+    TestTracksTheSinks();
+    TestFlagsTicksOutsideCombat();
+    TestRecordedLog();
+    ThreadPool::GetSingleton()->Shutdown();
+    return Check::Failures();
+}
@@ -0,0 +1,167 @@
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include "alloc_counter.h"
+#include "check.h"
+#include "fixed_containers.h"
+
+static void TestFixedVector() {
+    FixedVector<int, 4> items;
+    CHECK(items.empty());
+    CHECK_EQ(items.capacity(), 4u);
+
+    for (int i = 0; i < 4; ++i) {
+        CHECK(items.push_back(i * 10));
+    }
+    CHECK(items.full());
+    CHECK(!items.push_back(99));
+    CHECK_EQ(items.size(), 4u);
+    CHECK(items.contains(30));
+    CHECK(!items.contains(99));
+    CHECK_EQ(items[2], 20);
+
+    int sum = 0;
+    for (auto item : items) {
+        sum += item;
+    }
+    CHECK_EQ(sum, 60);
+
+    items.clear();
+    CHECK(items.empty());
+    CHECK(!items.contains(0));
+    CHECK(items.push_back(7));
+    CHECK_EQ(items[0], 7);
+}
+
+static void TestFormatBuffer() {
+    FormatBuffer<8> buffer;
+    CHECK(std::strcmp(buffer.Format("{}", 42), "42") == 0);
+    // Seven characters fit, the rest is cut
+    CHECK(std::strcmp(buffer.Format("{}", "0123456789"), "0123456") == 0);
+}
+
+static void TestFormIDFilter() {
+    FormIDFilter<4096> filter;
+    std::mt19937 random(7);
+
+    std::vector<RE::FormID> inserted;
+    for (int i = 0; i < 256; ++i) {
+        auto formID = static_cast<RE::FormID>(random());
+        inserted.push_back(formID);
+        filter.Insert(formID);
+    }
+
+    // Never a false negative
+    for (auto formID : inserted) {
+        CHECK(filter.MayContain(formID));
+    }
+
+    // FormIDs from the same plugin differ in the low bits only; they still have to spread
+    std::uint32_t falsePositives = 0;
+    constexpr std::uint32_t probes = 100000;
+    for (std::uint32_t i = 0; i < probes; ++i) {
+        auto formID = 0x0A000000u + i;
+        if (std::ranges::find(inserted, formID) == inserted.end() && filter.MayContain(formID)) {
+            ++falsePositives;
+        }
+    }
+    // 256 of 4096 bits set, so about 6% would be expected from a uniform hash
+    CHECK(falsePositives < probes / 10);
+
+    filter.Clear();
+    for (auto formID : inserted) {
+        CHECK(!filter.MayContain(formID));
+    }
+}
+
+static void TestFixedMap() {
+    FixedMap<RE::FormID, int, 16> map;
+    CHECK_EQ(map.capacity(), 12u);
+    CHECK(map.empty());
+
+    for (RE::FormID i = 1; i <= 12; ++i) {
+        auto value = map.try_emplace(i * 0x100);
+        CHECK(value != nullptr);
+        if (value) {
+            *value = static_cast<int>(i);
+        }
+    }
+    CHECK(map.full());
+    CHECK(!map.try_emplace(0xFFFF));
+    // A key that is already there is found even when full
+    CHECK(map.try_emplace(0x300) && *map.try_emplace(0x300) == 3);
+
+    CHECK_EQ(map.erase_if([](RE::FormID, int value) { return value % 2 == 0; }), 6u);
+    CHECK_EQ(map.size(), 6u);
+    for (RE::FormID i = 1; i <= 12; ++i) {
+        CHECK_EQ(map.contains(i * 0x100), i % 2 == 1);
+    }
+    CHECK(!map.erase(0x200));
+    CHECK(map.erase(0x100));
+    map.clear();
+    CHECK(map.empty());
+    CHECK(!map.contains(0x300));
+
+    // Random churn against std::unordered_map, with keys from one plugin that differ in the low bits only
+    FixedMap<std::uint64_t, std::uint32_t, 64> fixed;
+    std::unordered_map<std::uint64_t, std::uint32_t> reference;
+    std::mt19937 random(11);
+    std::uniform_int_distribution<std::uint64_t> pickKey(0, 99);
+    std::uniform_int_distribution<int> pickOp(0, 9);
+
+    std::uint64_t mismatches = 0;
+    for (int step = 0; step < 20000; ++step) {
+        auto key = (0xFF000800ull << 32) | pickKey(random);
+        auto op = pickOp(random);
+        if (op < 5) {
+            if (reference.contains(key) || reference.size() < fixed.capacity()) {
+                auto value = fixed.try_emplace(key);
+                mismatches += value == nullptr;
+                if (value) {
+                    *value = static_cast<std::uint32_t>(step);
+                    reference[key] = static_cast<std::uint32_t>(step);
+                }
+            }
+        } else if (op < 8) {
+            mismatches += fixed.erase(key) != (reference.erase(key) > 0);
+        } else if (op == 8) {
+            auto cutoff = static_cast<std::uint32_t>(step - 200);
+            fixed.erase_if([&](std::uint64_t, std::uint32_t value) { return value < cutoff; });
+            std::erase_if(reference, [&](const auto& entry) { return entry.second < cutoff; });
+        }
+
+        auto found = fixed.find(key);
+        auto it = reference.find(key);
+        mismatches += (found != nullptr) != (it != reference.end());
+        mismatches += found && it != reference.end() && *found != it->second;
+        mismatches += fixed.size() != reference.size();
+    }
+    CHECK_EQ(mismatches, 0u);
+
+    std::size_t visited = 0;
+    fixed.for_each([&](std::uint64_t key, std::uint32_t value) {
+        ++visited;
+        CHECK(reference.contains(key) && reference[key] == value);
+    });
+    CHECK_EQ(visited, reference.size());
+
+    // The reference allocates, so count only with the fixed map on its own
+    auto allocationsBefore = AllocCounter::Count();
+    for (int step = 0; step < 20000; ++step) {
+        auto key = pickKey(random);
+        if (step % 3 == 0) {
+            fixed.erase(key);
+        } else if (auto value = fixed.try_emplace(key)) {
+            *value = static_cast<std::uint32_t>(step);
+        }
+    }
+    CHECK_EQ(AllocCounter::Count() - allocationsBefore, 0u);
+}
+
+int main() {
+    TestFixedVector();
+    TestFormatBuffer();
+    TestFormIDFilter();
+    TestFixedMap();
+    return Check::Failures();
+}
@@ -0,0 +1,176 @@
+#include <random>
+#include <unordered_set>
+#include "check.h"
+#include "fixed_containers.h"
+#include "hit_route.h"
+
+// HitEventHandler's whole path for every hit in the world, over a million synthetic hits from a large
+// battle: RouteHit with the handler's filters in front of the strike weapon set and the roster, and the
+// event log, telemetry, strike and threat at the end of it. The same hits are routed by asking the hash
+// sets directly with nothing skipped, as the reference and the baseline, with the event log and the
+// counters each off and on.
+using namespace std::chrono;
+
+struct Hit {
+    RE::FormID source;
+    RE::FormID attacker;
+    RE::FormID victim;
+    bool heavy;
+};
+
+struct Outcome {
+    std::uint64_t records = 0;
+    std::uint64_t counted = 0;
+    std::uint64_t strikes = 0;
+    std::uint64_t threatHits = 0;
+    double threat = 0.0;
+
+    bool operator==(const Outcome&) const = default;
+};
+
+struct World {
+    std::unordered_set<RE::FormID> strikeWeapons;
+    FormIDFilter<8192> strikeFilter;
+    std::unordered_set<RE::FormID> roster;
+    FormIDFilter<4096> rosterFilter;
+    RE::FormID playerID = 0x00000014;
+    bool recording = false;
+    bool counting = false;
+};
+
+// The handler's GameHit with the game swapped for the world above
+struct SyntheticHit {
+    const Hit& hit;
+    const World& world;
+    Outcome& outcome;
+    std::uint64_t& attackerReads;
+
+    bool MayBeStrike() const { return world.strikeFilter.MayContain(hit.source); }
+    RE::FormID VictimID() const { return hit.victim; }
+    RE::FormID AttackerID() const {
+        ++attackerReads;
+        return hit.attacker;
+    }
+    bool IsRegistered(RE::FormID formID) const { return world.rosterFilter.MayContain(formID) && world.roster.contains(formID); }
+    bool IsPartyVictim(RE::FormID victimID) const { return IsRegistered(victimID) || victimID == world.playerID; }
+    bool IsRecording() const { return world.recording; }
+    bool IsCounting() const { return world.counting; }
+    bool IsHeavy() const { return hit.heavy; }
+    bool IsBlocked() const { return false; }
+
+    void Record(RE::FormID, RE::FormID) const { ++outcome.records; }
+    void Count(RE::FormID) const { ++outcome.counted; }
+
+    // OnStrikeHit confirms the weapon against the exact set
+    void Strike() const { outcome.strikes += world.strikeWeapons.contains(hit.source); }
+
+    void AddThreat(RE::FormID, RE::FormID, float amount) const {
+        ++outcome.threatHits;
+        outcome.threat += amount;
+    }
+};
+
+static Outcome RouteExactly(const World& world, std::span<const Hit> hits) {
+    Outcome outcome;
+    for (const auto& hit : hits) {
+        outcome.records += world.recording;
+        if (world.roster.contains(hit.attacker)) {
+            outcome.counted += world.counting;
+            outcome.strikes += world.strikeWeapons.contains(hit.source);
+        }
+        bool partyVictim = world.roster.contains(hit.victim) || hit.victim == world.playerID;
+        if (partyVictim && hit.victim != hit.attacker) {
+            ++outcome.threatHits;
+            outcome.threat += hit.heavy ? 2.0 : 1.0;
+        }
+    }
+    return outcome;
+}
+
+int main() {
+    std::mt19937 random(1234);
+    World world;
+
+    // A few strike weapons among a load order's worth of weapons and spells
+    std::vector<RE::FormID> sources;
+    for (RE::FormID i = 0; i < 3000; ++i) {
+        sources.push_back(0x00012E40 + i * 7);
+    }
+    world.strikeWeapons = { sources[10], sources[400], sources[1500], sources[2999] };
+    for (auto formID : world.strikeWeapons) {
+        world.strikeFilter.Insert(formID);
+    }
+
+    // The player and four followers among two hundred fighting NPCs
+    std::vector<RE::FormID> actors{ world.playerID };
+    for (RE::FormID i = 0; i < 200; ++i) {
+        actors.push_back(0xFF000800 + i);
+    }
+    world.roster = { actors[3], actors[50], actors[120], actors[199] };
+    for (auto formID : world.roster) {
+        world.rosterFilter.Insert(formID);
+    }
+
+    constexpr std::size_t hitCount = 1'000'000;
+    std::vector<Hit> hits(hitCount);
+    std::uniform_int_distribution<std::size_t> pickSource(0, sources.size() - 1);
+    std::uniform_int_distribution<std::size_t> pickActor(0, actors.size() - 1);
+    std::uniform_int_distribution<int> roll(0, 9);
+    for (auto& hit : hits) {
+        hit = { sources[pickSource(random)], actors[pickActor(random)], actors[pickActor(random)], roll(random) == 0 };
+    }
+    // Make sure the strike path is exercised, not just the rejection
+    for (std::size_t i = 0; i < hitCount; i += 997) {
+        hits[i] = { sources[400], actors[50], actors[7], false };
+    }
+
+    auto time = [](auto&& route, Outcome& out) {
+        auto best = nanoseconds::max();
+        for (int run = 0; run < 5; ++run) {
+            auto started = steady_clock::now();
+            out = route();
+            best = std::min(best, duration_cast<nanoseconds>(steady_clock::now() - started));
+        }
+        return best;
+    };
+
+    struct Mode {
+        const char* name;
+        bool recording;
+        bool counting;
+    };
+    for (auto mode : { Mode{ "quiet", false, false }, Mode{ "counting", false, true }, Mode{ "recording", true, true } }) {
+        world.recording = mode.recording;
+        world.counting = mode.counting;
+
+        std::uint64_t attackerReads = 0;
+        Outcome routed, exact;
+        auto routedTime = time([&] {
+            Outcome outcome;
+            attackerReads = 0;
+            for (const auto& hit : hits) {
+                SyntheticHit event{ hit, world, outcome, attackerReads };
+                RouteHit(event);
+            }
+            return outcome;
+        }, routed);
+        auto exactTime = time([&] { return RouteExactly(world, hits); }, exact);
+
+        // The early outs may only save work, never change what happens
+        CHECK(routed == exact);
+        CHECK(routed.strikes >= hitCount / 997);
+        CHECK(routed.threatHits > 0);
+
+        // With nothing recording or counting, only hits on the party and possible strikes look at the attacker
+        if (!mode.recording && !mode.counting) {
+            CHECK(attackerReads < hitCount / 10);
+        }
+
+        std::printf("1M hits, %s: routed %.2fns/hit, hash sets %.2fns/hit, attacker read for %.1f%% (%llu strikes, %llu threat hits)\n",
+            mode.name, static_cast<double>(routedTime.count()) / hitCount, static_cast<double>(exactTime.count()) / hitCount,
+            100.0 * static_cast<double>(attackerReads) / hitCount, static_cast<unsigned long long>(routed.strikes),
+            static_cast<unsigned long long>(routed.threatHits));
+    }
+
+    return Check::Failures();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// Stand-in for src/PCH.h when the engine-independent headers are built on a desktop compiler.
+// Provides just the CommonLibSSE and SKSE names those headers touch; nothing here talks to a game.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+using namespace std::literals;
+
+namespace RE {
+    using FormID = std::uint32_t;
+
+    enum class ActorValue : std::int32_t {
+        kNone = -1,
+        kOneHanded = 6,
+        kMarksman = 8,
+        kHealth = 24,
+        kMagicka = 25,
+        kStamina = 26
+    };
+
+    // Frame time the game wheel advances by; tests set it directly
+    inline float hostSecondsSinceLastFrame = 0.0f;
+    inline float GetSecondsSinceLastFrame() { return hostSecondsSinceLastFrame; }
+}
+
+namespace SKSE {
+    namespace log {
+        inline std::optional<std::filesystem::path> log_directory() { return std::filesystem::temp_directory_path(); }
+
+        template <class... Args>
+        void trace(fmt::format_string<Args...>, Args&&...) {}
+        template <class... Args>
+        void debug(fmt::format_string<Args...>, Args&&...) {}
+        template <class... Args>
+        void info(fmt::format_string<Args...>, Args&&...) {}
+        template <class... Args>
+        void warn(fmt::format_string<Args...> format, Args&&... args) { fmt::print(stderr, "warn: {}\n", fmt::format(format, std::forward<Args>(args)...)); }
+        template <class... Args>
+        void error(fmt::format_string<Args...> format, Args&&... args) { fmt::print(stderr, "error: {}\n", fmt::format(format, std::forward<Args>(args)...)); }
+    }
+
+    // Tasks queue up here until a test plays the game thread and runs them
+    class TaskInterface {
+    private:
+        std::mutex lock;
+        std::vector<std::function<void()>> tasks;
+
+    public:
+        void AddTask(std::function<void()> task) {
+            std::scoped_lock guard(lock);
+            tasks.push_back(std::move(task));
+        }
+
+        std::size_t RunPending() {
+            std::vector<std::function<void()>> running;
+            {
+                std::scoped_lock guard(lock);
+                running.swap(tasks);
+            }
+            for (auto& task : running) {
+                task();
+            }
+            return running.size();
+        }
+    };
+
+    inline TaskInterface* GetTaskInterface() {
+        static TaskInterface taskInterface;
+        return &taskInterface;
+    }
+}
+
+namespace logger = SKSE::log;
@@ -0,0 +1,162 @@
+#include <random>
+#include <unordered_set>
+#include "check.h"
+#include "hostility_cache.h"
+
+// The hostility scan at the start of each target refresh, for ten followers in a battle of fifty enemies
+// and thirty bystanders that are fighting someone else. The game's check is stood in for by a walk over
+// both actors' factions against a relation table, which is roughly what IsHostileToActor does. The scan
+// asking every follower about every actor is the baseline; the cache has to give the same answers.
+using namespace std::chrono;
+using CombatClasses::HostilityCache;
+
+struct Combatant {
+    RE::FormID formID;
+    std::vector<RE::FormID> factions;
+    RE::FormID targetID;
+};
+
+struct Relations {
+    std::unordered_set<std::uint64_t> enemies;
+
+    static std::uint64_t Key(RE::FormID a, RE::FormID b) { return (static_cast<std::uint64_t>(std::min(a, b)) << 32) | std::max(a, b); }
+
+    bool IsHostile(const Combatant& actor, const Combatant& member) const {
+        for (auto mine : actor.factions) {
+            for (auto theirs : member.factions) {
+                if (enemies.contains(Key(mine, theirs))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+constexpr std::size_t memberCount = 10;
+constexpr std::size_t enemyCount = 50;
+constexpr std::size_t bystanderCount = 30;
+constexpr int ticks = 3600;
+
+int main() {
+    std::mt19937 random(46);
+    std::uniform_int_distribution<RE::FormID> pickFaction(0, 199);
+
+    // Followers share the player's factions; enemies hold bandit factions, bystanders neither
+    Relations relations;
+    for (RE::FormID bandit = 100; bandit < 120; ++bandit) {
+        relations.enemies.insert(Relations::Key(bandit, 0));
+    }
+    std::vector<Combatant> members;
+    for (std::size_t i = 0; i < memberCount; ++i) {
+        members.push_back({ static_cast<RE::FormID>(0x00001000 + i), { 0, pickFaction(random), pickFaction(random) % 100 + 20 }, 0 });
+    }
+    std::vector<Combatant> actors;
+    for (std::size_t i = 0; i < enemyCount + bystanderCount; ++i) {
+        Combatant actor{ static_cast<RE::FormID>(0xFF000800 + i), {}, 0 };
+        for (int f = 0; f < 8; ++f) {
+            actor.factions.push_back(pickFaction(random) % 80 + 120);
+        }
+        if (i < enemyCount) {
+            actor.factions[3] = 100 + static_cast<RE::FormID>(i % 20);
+        }
+        actors.push_back(std::move(actor));
+    }
+
+    std::vector<RE::FormID> memberIDs;
+    for (const auto& member : members) {
+        memberIDs.push_back(member.formID);
+    }
+
+    auto exact = [&](const Combatant& actor) {
+        std::uint16_t hostileTo = 0;
+        for (std::size_t i = 0; i < members.size(); ++i) {
+            if (relations.IsHostile(actor, members[i])) {
+                hostileTo |= static_cast<std::uint16_t>(1u << i);
+            }
+        }
+        return hostileTo;
+    };
+
+    // Enemies switch targets now and then, which is when the cache asks again
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<std::size_t> pickMember(0, memberCount - 1);
+    auto retarget = [&] {
+        for (auto& actor : actors) {
+            if (roll(random) == 0) {
+                actor.targetID = members[pickMember(random)].formID;
+            }
+        }
+    };
+
+    // Baseline: every follower against every actor, every tick
+    std::uint64_t exactChecks = 0;
+    std::uint64_t hostileSeen = 0;
+    auto started = steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        retarget();
+        for (const auto& actor : actors) {
+            hostileSeen += exact(actor) != 0;
+            exactChecks += members.size();
+        }
+    }
+    auto exactTime = duration_cast<nanoseconds>(steady_clock::now() - started);
+    CHECK_EQ(hostileSeen, static_cast<std::uint64_t>(enemyCount) * ticks);
+
+    // Cached, with every answer compared to the game's
+    HostilityCache<16> cache;
+    std::uint64_t cachedChecks = 0;
+    auto cachedTime = nanoseconds::zero();
+    for (int tick = 0; tick < ticks; ++tick) {
+        retarget();
+        std::array<std::uint16_t, enemyCount + bystanderCount> answers;
+        auto tickStarted = steady_clock::now();
+        cache.BeginRefresh(memberIDs);
+        for (std::size_t a = 0; a < actors.size(); ++a) {
+            const auto& actor = actors[a];
+            answers[a] = cache.Get(actor.formID, actor.targetID, [&](std::size_t i) {
+                ++cachedChecks;
+                return relations.IsHostile(actor, members[i]);
+            });
+        }
+        cache.EndRefresh();
+        cachedTime += duration_cast<nanoseconds>(steady_clock::now() - tickStarted);
+
+        for (std::size_t a = 0; a < actors.size(); ++a) {
+            CHECK_EQ(answers[a], exact(actors[a]));
+        }
+    }
+    CHECK(cachedChecks * 4 < exactChecks);
+
+    // An enemy that makes peace is seen as such once its answer ages out and it gets its turn to be asked again
+    auto& convert = actors[0];
+    convert.factions[3] = 199;
+    auto bound = HostilityCache<16>::maxAge + static_cast<int>(actors.size() / HostilityCache<16>::maxRechecks) + 1;
+    int refreshes = 0;
+    std::uint16_t answer = 1;
+    while (answer != 0 && refreshes <= bound) {
+        cache.BeginRefresh(memberIDs);
+        for (const auto& actor : actors) {
+            auto hostileTo = cache.Get(actor.formID, actor.targetID, [&](std::size_t i) { return relations.IsHostile(actor, members[i]); });
+            if (actor.formID == convert.formID) {
+                answer = hostileTo;
+            }
+        }
+        cache.EndRefresh();
+        ++refreshes;
+    }
+    CHECK_EQ(answer, 0);
+    CHECK(refreshes <= bound);
+
+    // New members start over
+    memberIDs.pop_back();
+    cache.BeginRefresh(memberIDs);
+    CHECK_EQ(cache.Get(actors[1].formID, actors[1].targetID, [&](std::size_t i) { return relations.IsHostile(actors[1], members[i]); }),
+        static_cast<std::uint16_t>(exact(actors[1]) & 0x1FF));
+
+    std::printf("%zu followers x %zu actors: full scan %.2fus/tick (%llu checks), cached %.2fus/tick (%llu checks)\n", memberCount, actors.size(),
+        static_cast<double>(exactTime.count()) / ticks / 1000.0, static_cast<unsigned long long>(exactChecks),
+        static_cast<double>(cachedTime.count()) / ticks / 1000.0, static_cast<unsigned long long>(cachedChecks));
+
+    return Check::Failures();
+}
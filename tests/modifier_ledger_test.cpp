@@ -0,0 +1,165 @@
+#include <map>
+#include "check.h"
+#include "modifier_ledger.h"
+
+using CombatClasses::Modifier;
+using CombatClasses::ModifierLedger;
+using CombatClasses::ModifierOp;
+using AV = RE::ActorValue;
+
+// Actor values as the game would hold them, counting every write the ledger issues
+struct FakeActor {
+    std::map<AV, float> values;
+    std::uint32_t writes = 0;
+
+    std::uint32_t Flush(ModifierLedger& ledger) {
+        return ledger.Flush(
+            [this](AV actorValue) { return values[actorValue]; },
+            [this](AV actorValue, float value) {
+                values[actorValue] = value;
+                ++writes;
+            });
+    }
+};
+
+static void TestFolding() {
+    FakeActor actor;
+    actor.values[AV::kMarksman] = 50.0f;
+    actor.values[AV::kHealth] = 100.0f;
+
+    ModifierLedger ledger;
+    ledger.SetLayer(ModifierLedger::kBow, { { AV::kMarksman, ModifierOp::kAdd, 10.0f } });
+    ledger.SetLayer(ModifierLedger::kClass, { { AV::kMarksman, ModifierOp::kMultiply, 2.0f }, { AV::kHealth, ModifierOp::kSet, 300.0f } });
+
+    // Layers fold in order over the base: (50 + 10) * 2, and one write per changed value
+    CHECK_EQ(actor.Flush(ledger), 2u);
+    CHECK_EQ(actor.values[AV::kMarksman], 120.0f);
+    CHECK_EQ(actor.values[AV::kHealth], 300.0f);
+
+    // Nothing changed, nothing written
+    CHECK(!ledger.IsDirty());
+    CHECK_EQ(actor.Flush(ledger), 0u);
+    ledger.SetLayer(ModifierLedger::kBow, { { AV::kMarksman, ModifierOp::kAdd, 10.0f } });
+    CHECK(!ledger.IsDirty());
+
+    // Swapping one layer rewrites only what it touches
+    ledger.SetLayer(ModifierLedger::kBow, { { AV::kMarksman, ModifierOp::kAdd, 20.0f } });
+    CHECK_EQ(actor.Flush(ledger), 1u);
+    CHECK_EQ(actor.values[AV::kMarksman], 140.0f);
+    CHECK_EQ(actor.values[AV::kHealth], 300.0f);
+
+    ledger.ClearLayer(ModifierLedger::kBow);
+    CHECK_EQ(actor.Flush(ledger), 1u);
+    CHECK_EQ(actor.values[AV::kMarksman], 100.0f);
+
+    // Reset puts every value back and forgets them
+    ledger.Reset();
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kMarksman], 50.0f);
+    CHECK_EQ(actor.values[AV::kHealth], 100.0f);
+    CHECK(ledger.IsEmpty());
+}
+
+static void TestOutsideChanges() {
+    FakeActor actor;
+    actor.values[AV::kOneHanded] = 30.0f;
+
+    ModifierLedger ledger;
+    ledger.SetLayer(ModifierLedger::kClass, { { AV::kOneHanded, ModifierOp::kAdd, 15.0f } });
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kOneHanded], 45.0f);
+
+    // A level-up while the class is active moves the value by 1
+    actor.values[AV::kOneHanded] += 1.0f;
+
+    // The level is kept when the class comes off, and again once it goes back on
+    ledger.ClearLayer(ModifierLedger::kClass);
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kOneHanded], 31.0f);
+
+    ledger.SetLayer(ModifierLedger::kClass, { { AV::kOneHanded, ModifierOp::kAdd, 15.0f } });
+    actor.Flush(ledger);
+    actor.values[AV::kOneHanded] = 50.0f;
+    ledger.SetLayer(ModifierLedger::kWeaponProfile, { { AV::kOneHanded, ModifierOp::kAdd, 5.0f } });
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kOneHanded], 55.0f);
+    ledger.Reset();
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kOneHanded], 35.0f);
+}
+
+// The game saves the written values; the co-save carries the captures so the next session can undo them
+static void TestRestoreAfterLoad() {
+    FakeActor actor;
+    actor.values[AV::kMarksman] = 50.0f;
+    actor.values[AV::kHealth] = 100.0f;
+
+    ModifierLedger ledger;
+    ledger.SetLayer(ModifierLedger::kBaseImprovement, { { AV::kMarksman, ModifierOp::kAdd, 30.0f } });
+    ledger.SetLayer(ModifierLedger::kClass, { { AV::kHealth, ModifierOp::kMultiply, 2.0f } });
+    actor.Flush(ledger);
+
+    std::vector<ModifierLedger::Capture> saved;
+    ledger.ForEachCapture([&](const ModifierLedger::Capture& capture) { saved.push_back(capture); });
+    CHECK_EQ(saved.size(), 2u);
+
+    // A new process loads the boosted values, and a level-up had moved Marksman by 1 after the write
+    FakeActor loaded;
+    loaded.values = actor.values;
+    loaded.values[AV::kMarksman] += 1.0f;
+    for (const auto& capture : saved) {
+        loaded.values[capture.actorValue] = ModifierLedger::Restore(capture, loaded.values[capture.actorValue]);
+    }
+    CHECK_EQ(loaded.values[AV::kMarksman], 51.0f);
+    CHECK_EQ(loaded.values[AV::kHealth], 100.0f);
+
+    // Applying the same layers again lands where the last session was, not on top of it
+    ModifierLedger next;
+    next.SetLayer(ModifierLedger::kBaseImprovement, { { AV::kMarksman, ModifierOp::kAdd, 30.0f } });
+    next.SetLayer(ModifierLedger::kClass, { { AV::kHealth, ModifierOp::kMultiply, 2.0f } });
+    loaded.Flush(next);
+    CHECK_EQ(loaded.values[AV::kMarksman], 81.0f);
+    CHECK_EQ(loaded.values[AV::kHealth], 200.0f);
+}
+
+static void TestZeroMultiplier() {
+    auto parsed = CombatClasses::ParseModifier("Stamina", "*0");
+    CHECK(parsed.has_value());
+    if (parsed) {
+        CHECK(parsed->op == ModifierOp::kMultiply);
+        CHECK_EQ(parsed->value, 0.0f);
+    }
+
+    // Nothing is divided back out, so zeroing a value is undone exactly
+    FakeActor actor;
+    actor.values[AV::kStamina] = 80.0f;
+    ModifierLedger ledger;
+    ledger.SetLayer(ModifierLedger::kClass, { { AV::kStamina, ModifierOp::kMultiply, 0.0f } });
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kStamina], 0.0f);
+    ledger.ClearLayer(ModifierLedger::kClass);
+    actor.Flush(ledger);
+    CHECK_EQ(actor.values[AV::kStamina], 80.0f);
+}
+
+static void TestParseModifier() {
+    auto add = CombatClasses::ParseModifier("Marksman", "+25");
+    CHECK(add && add->op == ModifierOp::kAdd && add->value == 25.0f && add->actorValue == "Marksman");
+    auto bare = CombatClasses::ParseModifier("Marksman", "-10");
+    CHECK(bare && bare->op == ModifierOp::kAdd && bare->value == -10.0f);
+    auto set = CombatClasses::ParseModifier("aimSightedDelay", "=0.5");
+    CHECK(set && set->op == ModifierOp::kSet && set->value == 0.5f);
+    auto multiply = CombatClasses::ParseModifier("attackAngleMult", "*0.8");
+    CHECK(multiply && multiply->op == ModifierOp::kMultiply && multiply->value == 0.8f);
+    CHECK(!CombatClasses::ParseModifier("Marksman", "lots"));
+    CHECK(!CombatClasses::ParseModifier("Marksman", ""));
+}
+
+int main() {
+    TestFolding();
+    TestOutsideChanges();
+    TestRestoreAfterLoad();
+    TestZeroMultiplier();
+    TestParseModifier();
+    return Check::Failures();
+}
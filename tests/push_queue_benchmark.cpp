@@ -0,0 +1,109 @@
+#include <random>
+#include "alloc_counter.h"
+#include "check.h"
+#include "push_queue.h"
+
+// Knockbacks in a large melee: eight followers with area knockback in a crowd of a hundred enemies,
+// queued through the tick and flushed once per frame under each iMaxPushesPerFrame worth trying. Checks
+// the cap, the order, that a target is never queued twice and that nothing is lost without being
+// counted, and reports how long pushes wait and what queueing and flushing cost per frame.
+using namespace std::chrono;
+
+constexpr std::size_t followerCount = 8;
+constexpr std::size_t enemyCount = 100;
+constexpr std::size_t areaTargets = 16;
+constexpr int frames = 20000;
+
+using Queue = PushQueue<std::uint32_t, 64>;
+
+struct Outcome {
+    std::uint64_t queued = 0;
+    std::uint64_t dispatched = 0;
+    std::uint64_t waitedFrames = 0;
+    int longestWait = 0;
+    nanoseconds elapsed{};
+    std::uint64_t allocations = 0;
+};
+
+static Outcome Run(std::size_t maxPushesPerFrame) {
+    std::mt19937 random(36);
+    std::uniform_int_distribution<int> roll(0, 99);
+    std::uniform_int_distribution<std::uint32_t> pickEnemy(0, enemyCount - 1);
+
+    Queue queue;
+    Outcome outcome;
+    std::array<int, enemyCount> queuedAt{};
+    std::array<bool, enemyCount> waiting{};
+    int lastQueuedAt = 0;
+
+    auto allocationsBefore = AllocCounter::Count();
+    for (int frame = 0; frame < frames; ++frame) {
+        auto started = steady_clock::now();
+
+        // A power attack lands now and then and throws everyone in the area
+        for (std::uint32_t follower = 0; follower < followerCount; ++follower) {
+            if (roll(random) >= 5) {
+                continue;
+            }
+            auto first = pickEnemy(random);
+            for (std::uint32_t i = 0; i < areaTargets; ++i) {
+                auto target = (first + i) % enemyCount;
+                bool wasWaiting = waiting[target];
+                if (queue.Queue(1000 + follower, target, 1.5f)) {
+                    CHECK(!wasWaiting);
+                    waiting[target] = true;
+                    queuedAt[target] = frame;
+                    ++outcome.queued;
+                }
+            }
+        }
+
+        std::size_t flushed = 0;
+        queue.Flush(maxPushesPerFrame, [&](const Queue::Push& push) {
+            ++flushed;
+            CHECK(waiting[push.target]);
+            CHECK(queuedAt[push.target] >= lastQueuedAt);
+            lastQueuedAt = queuedAt[push.target];
+            waiting[push.target] = false;
+
+            auto waited = frame - queuedAt[push.target];
+            outcome.waitedFrames += waited;
+            outcome.longestWait = std::max(outcome.longestWait, waited);
+            return true;
+        });
+        CHECK(flushed <= maxPushesPerFrame);
+
+        outcome.elapsed += duration_cast<nanoseconds>(steady_clock::now() - started);
+    }
+    outcome.allocations = AllocCounter::Count() - allocationsBefore;
+    outcome.dispatched = queue.GetDispatched();
+
+    // Every push that made it into the queue either went out or is still waiting
+    CHECK_EQ(outcome.queued, outcome.dispatched + queue.size());
+    return outcome;
+}
+
+int main() {
+    for (std::size_t maxPushesPerFrame : { 1u, 2u, 4u, 16u }) {
+        auto outcome = Run(maxPushesPerFrame);
+        CHECK_EQ(outcome.allocations, 0u);
+        CHECK(outcome.dispatched > 0);
+
+        std::printf("cap %2zu: %.1fns/frame, %llu pushes, mean wait %.2f frames, longest %d\n", maxPushesPerFrame,
+            static_cast<double>(outcome.elapsed.count()) / frames, static_cast<unsigned long long>(outcome.dispatched),
+            static_cast<double>(outcome.waitedFrames) / std::max<std::uint64_t>(outcome.dispatched, 1), outcome.longestWait);
+    }
+
+    // A full queue drops and counts what doesn't fit; pushes that can't be dispatched still leave the queue
+    Queue queue;
+    for (std::uint32_t target = 0; target < 80; ++target) {
+        queue.Queue(1, target, 1.0f);
+    }
+    CHECK_EQ(queue.size(), 64u);
+    CHECK_EQ(queue.GetDropped(), 16u);
+    queue.Flush(64, [](const Queue::Push&) { return false; });
+    CHECK(queue.empty());
+    CHECK_EQ(queue.GetDispatched(), 0u);
+
+    return Check::Failures();
+}
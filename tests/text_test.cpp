@@ -0,0 +1,137 @@
+#include "check.h"
+#include "text.h"
+
+using namespace Text;
+
+static std::vector<std::string_view> Split(std::string_view text, std::string_view delimiter) {
+    std::vector<std::string_view> pieces;
+    Tokenizer(text, delimiter).ForEach([&](std::string_view piece) { pieces.push_back(piece); });
+    return pieces;
+}
+
+static void TestTokenizer() {
+    CHECK((Split("a,b,,c", ",") == std::vector<std::string_view>{ "a", "b", "", "c" }));
+    CHECK((Split("", ",") == std::vector<std::string_view>{ "" }));
+    CHECK((Split("a,", ",") == std::vector<std::string_view>{ "a", "" }));
+    CHECK((Split("a::b", "::") == std::vector<std::string_view>{ "a", "b" }));
+    CHECK((Split("whole", "") == std::vector<std::string_view>{ "whole" }));
+
+    // Returning false stops the walk
+    int visited = 0;
+    Tokenizer("1|2|3|4", "|").ForEach([&](std::string_view piece) {
+        ++visited;
+        return piece != "2";
+    });
+    CHECK_EQ(visited, 2);
+}
+
+static void TestStrings() {
+    CHECK_EQ(Trim("  \tvalue \r\n"), "value"sv);
+    CHECK_EQ(Trim("   "), ""sv);
+    CHECK(IEquals("Marksman", "mARKSMAN"));
+    CHECK(!IEquals("Marksman", "Marksma"));
+    CHECK(IContains("Follower Archer Class", "archer"));
+    CHECK(!IContains("Bow", "Bows"));
+    CHECK_EQ(IHash{}("OneHanded"), IHash{}("onehanded"));
+}
+
+static void TestNumbers() {
+    CHECK(ParseNumber<int>(" 42 ") == 42);
+    CHECK(ParseNumber<int>("+7") == 7);
+    CHECK(ParseNumber<int>("-7") == -7);
+    CHECK(!ParseNumber<int>("7x"));
+    CHECK(!ParseNumber<int>(""));
+    CHECK(!ParseNumber<int>("+"));
+    CHECK(ParseNumber<std::uint32_t>("0x0001A2B3", 16) == 0x1A2B3u);
+    CHECK(ParseNumber<std::uint32_t>("ff", 16) == 0xFFu);
+    CHECK(ParseNumber<float>("0.25") == 0.25f);
+    CHECK(!ParseNumber<float>("0.25f"));
+
+    CHECK(ParseBool("Yes") == true);
+    CHECK(ParseBool(" off ") == false);
+    CHECK(ParseBool("1") == true);
+    CHECK(!ParseBool("maybe"));
+}
+
+static std::filesystem::path WriteTemporary(std::string_view name, std::string_view contents) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    return path;
+}
+
+static void TestIniDocument() {
+    auto path = WriteTemporary("cs_text_test.ini",
+        "\xEF\xBB\xBF"
+        "loose = 1\n"
+        "; comment\n"
+        "[General]\r\n"
+        "fDistance = 512.5 ; inline comment\n"
+        "sName = Bow;NoSpace\n"
+        "bEnabled = true\n"
+        "iCount = 3\n"
+        "iCount = 4\n"
+        "# another comment\n"
+        "[ Archer ]\n"
+        "Marksman = +25\n");
+
+    IniDocument document;
+    CHECK(document.Load(path));
+    CHECK_EQ(document.GetSections().size(), 3u);
+    CHECK_EQ(document.GetSections().front().GetValue("loose"), "1"sv);
+
+    auto general = document.FindSection("general");
+    CHECK(general != nullptr);
+    if (general) {
+        CHECK_EQ(general->GetNumber("fDistance", 0.0f), 512.5f);
+        CHECK_EQ(general->GetValue("sName"), "Bow;NoSpace"sv);
+        CHECK(general->GetBool("BENABLED", false));
+        CHECK_EQ(general->GetNumber("iCount", 0), 4);
+        CHECK_EQ(general->GetNumber("iMissing", 9), 9);
+    }
+
+    auto archer = document.FindSection("Archer");
+    CHECK(archer != nullptr);
+    if (archer) {
+        CHECK_EQ(archer->GetValue("marksman"), "+25"sv);
+    }
+
+    CHECK(!document.Load(path.string() + ".missing"));
+    CHECK(document.GetSections().empty());
+    std::filesystem::remove(path);
+}
+
+static void TestDuplicateSections() {
+    auto path = WriteTemporary("cs_text_duplicate_test.ini",
+        "[General]\n"
+        "fDistance = 100\n"
+        "bEnabled = false\n"
+        "[Archer]\n"
+        "Marksman = +25\n"
+        "[GENERAL]\n"
+        "bEnabled = true\n"
+        "iCount = 2\n");
+
+    // The second [General] continues the first instead of hiding it
+    IniDocument document;
+    CHECK(document.Load(path));
+    CHECK_EQ(document.GetSections().size(), 3u);
+
+    auto general = document.FindSection("General");
+    CHECK(general != nullptr);
+    if (general) {
+        CHECK_EQ(general->entries.size(), 4u);
+        CHECK_EQ(general->GetNumber("fDistance", 0.0f), 100.0f);
+        CHECK(general->GetBool("bEnabled", false));
+        CHECK_EQ(general->GetNumber("iCount", 0), 2);
+    }
+    std::filesystem::remove(path);
+}
+
+int main() {
+    TestTokenizer();
+    TestStrings();
+    TestNumbers();
+    TestIniDocument();
+    TestDuplicateSections();
+    return Check::Failures();
+}
@@ -0,0 +1,103 @@
+#include <thread>
+#include "check.h"
+#include "thread_pool.h"
+
+using namespace std::chrono;
+
+static bool WaitFor(const std::atomic<std::uint64_t>& counter, std::uint64_t expected) {
+    auto deadline = steady_clock::now() + 30s;
+    while (counter.load() < expected && steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    return counter.load() == expected;
+}
+
+// Many tiny jobs from the game thread and from the workers themselves, so queues fill unevenly and
+// idle workers have to steal
+static void TestThroughput(ThreadPool& pool) {
+    constexpr std::uint64_t outer = 20000;
+    constexpr std::uint64_t inner = 4;
+    std::atomic<std::uint64_t> done{ 0 };
+
+    auto started = steady_clock::now();
+    for (std::uint64_t i = 0; i < outer; ++i) {
+        pool.Submit([&pool, &done] {
+            for (std::uint64_t j = 0; j < inner; ++j) {
+                pool.Submit([&done] { done.fetch_add(1); });
+            }
+            done.fetch_add(1);
+        });
+    }
+    CHECK(WaitFor(done, outer * (inner + 1)));
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - started).count();
+    std::printf("%llu jobs on %zu workers in %lldus\n", static_cast<unsigned long long>(outer * (inner + 1)), pool.GetWorkerCount(), static_cast<long long>(elapsed));
+}
+
+// A lone job on an idle pool has to wake a sleeping worker promptly
+static void TestWakeLatency(ThreadPool& pool) {
+    microseconds worst{ 0 };
+    for (int i = 0; i < 200; ++i) {
+        std::this_thread::sleep_for(200us);
+        std::atomic<std::uint64_t> done{ 0 };
+        auto submitted = steady_clock::now();
+        pool.Submit([&done] { done.fetch_add(1); });
+        CHECK(WaitFor(done, 1));
+        worst = std::max(worst, duration_cast<microseconds>(steady_clock::now() - submitted));
+    }
+    std::printf("worst wake latency %lldus\n", static_cast<long long>(worst.count()));
+}
+
+static void TestContinuations(ThreadPool& pool) {
+    auto gameThread = std::this_thread::get_id();
+    std::atomic<std::uint64_t> computed{ 0 };
+    std::vector<int> results;
+    bool ranOnGameThread = true;
+
+    for (int i = 0; i < 100; ++i) {
+        pool.Submit(
+            [i, &computed] {
+                computed.fetch_add(1);
+                return i * i;
+            },
+            [&, gameThread](int result) {
+                ranOnGameThread &= std::this_thread::get_id() == gameThread;
+                results.push_back(result);
+            });
+    }
+    CHECK(WaitFor(computed, 100));
+
+    // Continuations wait for the game thread and arrive batched into few tasks
+    auto deadline = steady_clock::now() + 10s;
+    std::size_t tasks = 0;
+    while (results.size() < 100 && steady_clock::now() < deadline) {
+        tasks += SKSE::GetTaskInterface()->RunPending();
+        std::this_thread::sleep_for(1ms);
+    }
+    CHECK_EQ(results.size(), 100u);
+    CHECK(ranOnGameThread);
+    CHECK(tasks <= results.size());
+
+    std::ranges::sort(results);
+    CHECK_EQ(results.back(), 99 * 99);
+}
+
+int main() {
+    auto pool = ThreadPool::GetSingleton();
+    pool->Start(4);
+    CHECK_EQ(pool->GetWorkerCount(), 4u);
+
+    TestThroughput(*pool);
+    TestWakeLatency(*pool);
+    TestContinuations(*pool);
+
+    pool->Shutdown();
+    CHECK_EQ(pool->GetWorkerCount(), 0u);
+
+    // Submitting after a shutdown starts the pool again
+    std::atomic<std::uint64_t> done{ 0 };
+    pool->Submit([&done] { done.fetch_add(1); });
+    CHECK(WaitFor(done, 1));
+    pool->Shutdown();
+
+    return Check::Failures();
+}
@@ -0,0 +1,127 @@
+#include <random>
+#include "check.h"
+#include "threat_map.h"
+
+using CombatClasses::ThreatMap;
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono;
+
+constexpr RE::FormID lydia = 0x000A2C94;
+constexpr RE::FormID player = 0x00000014;
+constexpr RE::FormID bandit = 0xFF000801;
+constexpr RE::FormID wolf = 0xFF000802;
+
+static bool Near(float actual, float expected, float tolerance = 1e-3f) {
+    return std::abs(actual - expected) <= tolerance * std::max(1.0f, std::abs(expected));
+}
+
+static ThreatMap* Fresh(float halfLife, Clock::time_point now) {
+    auto map = ThreatMap::GetSingleton();
+    map->SetHalfLife(halfLife);
+    map->Clear(now);
+    return map;
+}
+
+static void TestHalfLife() {
+    auto start = Clock::now();
+    auto map = Fresh(10.0f, start);
+    map->AddHit(lydia, bandit, 4.0f, start);
+    map->AddHit(player, bandit, 1.0f, start);
+
+    CHECK(Near(map->GetThreat(lydia, bandit, start), 4.0f));
+    CHECK(Near(map->GetThreat(lydia, bandit, start + 10s), 2.0f));
+    CHECK(Near(map->GetThreat(lydia, bandit, start + 30s), 0.5f));
+    CHECK(Near(map->GetThreat(player, bandit, start + 10s), 0.5f));
+    CHECK_EQ(map->GetThreat(lydia, wolf, start), 0.0f);
+    CHECK_EQ(map->GetThreat(bandit, lydia, start), 0.0f);
+
+    // A later hit adds at full strength on top of what is left
+    map->AddHit(lydia, bandit, 1.0f, start + 10s);
+    CHECK(Near(map->GetThreat(lydia, bandit, start + 10s), 3.0f));
+    CHECK(Near(map->GetThreat(lydia, bandit, start + 20s), 1.5f));
+
+    // No half-life, no decay
+    map = Fresh(0.0f, start);
+    map->AddHit(lydia, bandit, 2.0f, start);
+    CHECK(Near(map->GetThreat(lydia, bandit, start + 3600s), 2.0f));
+}
+
+// Hits spread over far more time than the epoch covers: every rebase has to keep the scores exact
+static void TestEpochRollover() {
+    auto start = Clock::now();
+    auto map = Fresh(10.0f, start);
+
+    double expected = 0.0;
+    auto last = start;
+    for (int i = 0; i < 200; ++i) {
+        auto now = start + seconds(37 * i);
+        expected *= std::exp2(-duration<double>(now - last).count() / 10.0);
+        last = now;
+
+        map->AddHit(lydia, bandit, 3.0f, now);
+        expected += 3.0;
+
+        auto threat = map->GetThreat(lydia, bandit, now);
+        CHECK(std::isfinite(threat));
+        CHECK(Near(threat, static_cast<float>(expected)));
+    }
+
+    // A long quiet spell decays to nothing without overflowing once the next hit rebases
+    auto later = last + 2h;
+    CHECK(map->GetThreat(lydia, bandit, later) < 1e-6f);
+    map->AddHit(lydia, wolf, 1.0f, later);
+    CHECK(Near(map->GetThreat(lydia, wolf, later), 1.0f));
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, later), wolf);
+}
+
+static void TestTopThreat() {
+    auto start = Clock::now();
+    auto map = Fresh(10.0f, start);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, start), 0u);
+
+    // Equal hits, the newer one weighs more
+    map->AddHit(lydia, bandit, 1.0f, start);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, start), bandit);
+    map->AddHit(lydia, wolf, 1.0f, start + 5s);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, start + 5s), wolf);
+
+    // Enough older blows still win
+    map->AddHit(lydia, bandit, 1.0f, start + 5s);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, start + 5s), bandit);
+
+    // Below the minimum nobody is the top threat, though the order is kept
+    CHECK_EQ(map->GetTopThreat(lydia, 0.5f, start + 10s), bandit);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.5f, start + 60s), 0u);
+    CHECK_EQ(map->GetTopThreat(lydia, 0.0f, start + 60s), bandit);
+
+    // Random hits from more enemies than a table holds: the tracked top is always the strongest slot
+    map = Fresh(10.0f, start);
+    std::mt19937 random(48);
+    std::uniform_int_distribution<RE::FormID> pickEnemy(0, 19);
+    std::uniform_real_distribution<float> pickAmount(0.5f, 2.0f);
+    std::uniform_int_distribution<int> pickGap(0, 3000);
+    auto now = start;
+    for (int i = 0; i < 5000; ++i) {
+        now += milliseconds(pickGap(random));
+        map->AddHit(lydia, bandit + pickEnemy(random), pickAmount(random), now);
+
+        RE::FormID strongest = 0;
+        float strongestThreat = 0.0f;
+        for (RE::FormID enemy = bandit; enemy < bandit + 20; ++enemy) {
+            auto threat = map->GetThreat(lydia, enemy, now);
+            if (threat > strongestThreat) {
+                strongest = enemy;
+                strongestThreat = threat;
+            }
+        }
+        auto top = map->GetTopThreat(lydia, 0.0f, now);
+        CHECK(top == strongest || Near(map->GetThreat(lydia, top, now), strongestThreat, 1e-5f));
+    }
+}
+
+int main() {
+    TestHalfLife();
+    TestEpochRollover();
+    TestTopThreat();
+    return Check::Failures();
+}
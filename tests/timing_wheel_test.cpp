@@ -0,0 +1,224 @@
+#include <random>
+#include "alloc_counter.h"
+#include "check.h"
+#include "timing_wheel.h"
+
+using Timers::TimingWheel;
+using namespace std::chrono;
+
+static void TestOrdering() {
+    TimingWheel wheel;
+    std::vector<int> fired;
+    wheel.Schedule(5ms, [&] { fired.push_back(5); });
+    wheel.Schedule(1ms, [&] { fired.push_back(1); });
+    wheel.Schedule(3ms, [&] { fired.push_back(3); });
+
+    wheel.Advance(10ms);
+    CHECK((fired == std::vector<int>{ 1, 3, 5 }));
+    CHECK(wheel.empty());
+}
+
+static void TestNeverEarly() {
+    TimingWheel wheel;
+    bool fired = false;
+    wheel.Schedule(10ms, [&] { fired = true; });
+
+    wheel.Advance(9999us);
+    CHECK(!fired);
+    wheel.Advance(1us);
+    CHECK(fired);
+
+    // A partial tick rounds the deadline up
+    fired = false;
+    wheel.Schedule(1500us, [&] { fired = true; });
+    wheel.Advance(1ms);
+    CHECK(!fired);
+    wheel.Advance(1ms);
+    CHECK(fired);
+}
+
+static void TestScheduleBetweenTicks() {
+    TimingWheel wheel;
+    bool fired = false;
+
+    // Scheduled 0.9ms into a tick, 2ms from now is 2.9ms on the wheel, which rounds up to the 3ms tick
+    wheel.Advance(900us);
+    wheel.Schedule(2ms, [&] { fired = true; });
+    wheel.Advance(1900us);
+    CHECK(!fired);
+    wheel.Advance(100us);
+    CHECK(!fired);
+    wheel.Advance(100us);
+    CHECK(fired);
+}
+
+static void TestRemainderCarry() {
+    TimingWheel wheel;
+    int firedAfter = 0;
+    int steps = 0;
+    wheel.Schedule(10ms, [&] { firedAfter = steps; });
+
+    // Half-tick frames add up instead of being dropped
+    while (steps < 40 && !firedAfter) {
+        ++steps;
+        wheel.Advance(500us);
+    }
+    CHECK_EQ(firedAfter, 20);
+}
+
+static void TestCancel() {
+    TimingWheel wheel;
+    bool fired = false;
+    auto id = wheel.Schedule(5ms, [&] { fired = true; });
+    CHECK(wheel.IsScheduled(id));
+    CHECK(wheel.Cancel(id));
+    CHECK(!wheel.IsScheduled(id));
+    CHECK(!wheel.Cancel(id));
+
+    wheel.Advance(10ms);
+    CHECK(!fired);
+
+    // A recycled slot must not answer to the old ID
+    auto reused = wheel.Schedule(5ms, [&] { fired = true; });
+    CHECK(!wheel.Cancel(id));
+    CHECK(wheel.IsScheduled(reused));
+    wheel.Advance(5ms);
+    CHECK(fired);
+    CHECK(!wheel.Cancel(reused));
+    CHECK(id != Timers::kNoTimer && reused != Timers::kNoTimer);
+}
+
+static void TestCascade() {
+    TimingWheel wheel;
+    constexpr auto frame = 16ms;
+    milliseconds elapsed{ 0 };
+
+    // One deadline per level
+    std::array<milliseconds, 4> delays{ 200ms, 300ms, 70s, 5h };
+    std::array<milliseconds, 4> firedAt{};
+    for (std::size_t i = 0; i < delays.size(); ++i) {
+        wheel.Schedule(delays[i], [&, i] { firedAt[i] = elapsed; });
+    }
+
+    while (!wheel.empty() && elapsed < 6h) {
+        elapsed += frame;
+        wheel.Advance(frame);
+    }
+    for (std::size_t i = 0; i < delays.size(); ++i) {
+        CHECK(firedAt[i] >= delays[i]);
+        CHECK(firedAt[i] < delays[i] + frame);
+    }
+}
+
+static void TestLongJumpAndReentry() {
+    TimingWheel wheel;
+    int fired = 0;
+    wheel.Schedule(5s, [&] {
+        ++fired;
+        wheel.Schedule(2ms, [&] { ++fired; });
+    });
+
+    // One jump far past several deadlines fires them all, including one scheduled on the way
+    wheel.Advance(1h);
+    CHECK_EQ(fired, 2);
+    CHECK(wheel.empty());
+
+    // A timer scheduled from a callback counts from that callback's deadline, not the end of the jump
+    fired = 0;
+    wheel.Schedule(5s, [&] {
+        ++fired;
+        wheel.Schedule(2ms, [&] { ++fired; });
+    });
+    wheel.Advance(5s);
+    CHECK_EQ(fired, 1);
+    wheel.Advance(1ms);
+    CHECK_EQ(fired, 1);
+    wheel.Advance(1ms);
+    CHECK_EQ(fired, 2);
+}
+
+static void TestClear() {
+    TimingWheel wheel;
+    bool fired = false;
+    auto id = wheel.Schedule(1ms, [&] { fired = true; });
+    wheel.Schedule(1min, [&] { fired = true; });
+    wheel.Clear();
+    CHECK(wheel.empty());
+    CHECK(!wheel.IsScheduled(id));
+    wheel.Advance(2min);
+    CHECK(!fired);
+}
+
+// 10k timers spread over a minute, driven by 60 fps frames until all have fired. Once the storage has
+// grown, the same load has to run without a single allocation.
+static void TestManyTimers() {
+    constexpr std::size_t count = 10000;
+    constexpr auto frame = microseconds(16667);
+
+    TimingWheel wheel;
+    std::mt19937 random(31);
+    std::uniform_int_distribution<std::int64_t> delayMs(1, 60000);
+    std::vector<milliseconds> delays(count);
+    for (auto& delay : delays) {
+        delay = milliseconds(delayMs(random));
+    }
+
+    struct Progress {
+        std::size_t fired = 0;
+        std::size_t early = 0;
+        microseconds elapsed{ 0 };
+    } progress;
+    auto& fired = progress.fired;
+    auto& early = progress.early;
+    auto& elapsed = progress.elapsed;
+
+    auto run = [&] {
+        fired = 0;
+        early = 0;
+        auto start = elapsed;
+        for (const auto& delay : delays) {
+            auto deadline = start + delay;
+            // A pointer and a deadline fit std::function's inline storage, so scheduling itself doesn't allocate
+            wheel.Schedule(delay, [state = &progress, deadline] {
+                ++state->fired;
+                state->early += state->elapsed < deadline;
+            });
+        }
+        while (!wheel.empty()) {
+            elapsed += frame;
+            wheel.Advance(frame);
+        }
+    };
+
+    auto started = steady_clock::now();
+    run();
+    auto firstRun = steady_clock::now() - started;
+    CHECK_EQ(fired, count);
+    CHECK_EQ(early, 0u);
+
+    auto allocationsBefore = AllocCounter::Count();
+    started = steady_clock::now();
+    run();
+    auto secondRun = steady_clock::now() - started;
+    CHECK_EQ(AllocCounter::Count() - allocationsBefore, 0u);
+    CHECK_EQ(fired, count);
+    CHECK_EQ(early, 0u);
+
+    std::printf("10k timers over %lld frames: first run %lldus, steady state %lldus\n",
+        static_cast<long long>(elapsed / frame / 2),
+        static_cast<long long>(duration_cast<microseconds>(firstRun).count()),
+        static_cast<long long>(duration_cast<microseconds>(secondRun).count()));
+}
+
+int main() {
+    TestOrdering();
+    TestNeverEarly();
+    TestScheduleBetweenTicks();
+    TestRemainderCarry();
+    TestCancel();
+    TestCascade();
+    TestLongJumpAndReentry();
+    TestClear();
+    TestManyTimers();
+    return Check::Failures();
+}